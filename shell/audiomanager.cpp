@@ -21,7 +21,12 @@
 #include "audiomanager.h"
 
 #include <qmath.h>
+#include <alsa/asoundlib.h>
 #include <quietmodedaemon.h>
+#include <mpris/mprisengine.h>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 
 AudioManager::AudioManager(QObject *parent) : QObject(parent)
 {
@@ -32,6 +37,17 @@ AudioManager::AudioManager(QObject *parent) : QObject(parent)
     pa_proplist_sets(propList, PA_PROP_APPLICATION_ID, "org.thesuite.theshell");
     pa_proplist_sets(propList, PA_PROP_APPLICATION_ICON_NAME, "theshell");
 
+    //Volume updates for ducking are batched and sent at most once per tick
+    duckTimer = new QTimer(this);
+    duckTimer->setInterval(50);
+    connect(duckTimer, &QTimer::timeout, this, &AudioManager::duckTick);
+
+    //Sounds much better if we delay restoring streams by a second
+    restoreDelayTimer = new QTimer(this);
+    restoreDelayTimer->setInterval(1000);
+    restoreDelayTimer->setSingleShot(true);
+    connect(restoreDelayTimer, &QTimer::timeout, this, &AudioManager::updateDuckTarget);
+
     pulseContext = pa_context_new_with_proplist(pulseLoopApi, NULL, propList);
     pa_proplist_free(propList);
     pa_context_set_state_callback(pulseContext, &AudioManager::pulseStateChanged, this);
@@ -88,30 +104,13 @@ void AudioManager::setMasterVolume(int volume) {
             }
             pa_context_set_sink_volume_by_index(pulseContext, defaultSinkIndex, &newVol, NULL, NULL);
         } else {
-            //Get Current Limits
-            QProcess* mixer = new QProcess();
-            mixer->start("amixer");
-            mixer->waitForFinished();
-            QString output(mixer->readAll());
-
-            bool readLine = false;
-            int limit;
-            for (QString line : output.split("\n")) {
-                if (line.startsWith(" ") && readLine) {
-                    if (line.startsWith("  Limits:")) {
-                        limit = line.split(" ").last().toInt();
-                    }
-                } else {
-                    if (line.contains("'Master'")) {
-                        readLine = true;
-                    } else {
-                        readLine = false;
-                    }
-                }
+            snd_mixer_elem_t* master = alsaMasterElement();
+            if (master != nullptr) {
+                long min, max;
+                snd_mixer_selem_get_playback_volume_range(master, &min, &max);
+                snd_mixer_selem_set_playback_volume_all(master, min + qRound((max - min) * (volume / (float) 100)));
+                if (snd_mixer_selem_has_playback_switch(master)) snd_mixer_selem_set_playback_switch_all(master, 1);
             }
-
-            mixer->start("amixer set Master " + QString::number(limit * (volume / (float) 100)) + " on");
-            connect(mixer, SIGNAL(finished(int)), mixer, SLOT(deleteLater()));
         }
     }
 }
@@ -122,197 +121,528 @@ int AudioManager::MasterVolume() {
         int currentVol = qCeil(((float) (avgVol - PA_VOLUME_MUTED) / (float) PA_VOLUME_NORM) * 100);
         return currentVol;
     } else {
-        //Get Current Volume
-        QProcess* mixer = new QProcess(this);
-        mixer->start("amixer");
-        mixer->waitForFinished();
-        QString output(mixer->readAll());
-        delete mixer;
-
-        bool readLine = false;
-        for (QString line : output.split("\n")) {
-            if (line.startsWith(" ") && readLine) {
-                if (line.startsWith("  Front Left:")) {
-                    if (line.contains("[off]")) {
-                        return 0;
-                    } else {
-                        QString percent = line.mid(line.indexOf("\[") + 1, 3).remove("\%").remove("]");
-                        return percent.toInt();
-                    }
-                }
-            } else {
-                if (line.contains("'Master'")) {
-                    readLine = true;
-                } else {
-                    readLine = false;
-                }
-            }
+        snd_mixer_elem_t* master = alsaMasterElement();
+        if (master == nullptr) return 0;
+
+        int enabled = 1;
+        if (snd_mixer_selem_has_playback_switch(master)) snd_mixer_selem_get_playback_switch(master, SND_MIXER_SCHN_FRONT_LEFT, &enabled);
+        if (!enabled) return 0;
+
+        long min, max, volume;
+        snd_mixer_selem_get_playback_volume_range(master, &min, &max);
+        snd_mixer_selem_get_playback_volume(master, SND_MIXER_SCHN_FRONT_LEFT, &volume);
+        if (max == min) return 0;
+        return qRound((volume - min) * 100 / (float) (max - min));
+    }
+}
+
+snd_mixer_elem_t* AudioManager::alsaMasterElement() {
+    //Open the mixer once and keep it around so volume keys never wait on anything
+    if (alsaMixer == nullptr) {
+        if (snd_mixer_open(&alsaMixer, 0) < 0) {
+            alsaMixer = nullptr;
+            return nullptr;
+        }
+
+        if (snd_mixer_attach(alsaMixer, "default") < 0 || snd_mixer_selem_register(alsaMixer, NULL, NULL) < 0 || snd_mixer_load(alsaMixer) < 0) {
+            snd_mixer_close(alsaMixer);
+            alsaMixer = nullptr;
+            return nullptr;
         }
+    } else {
+        //Pick up changes made by anyone else
+        snd_mixer_handle_events(alsaMixer);
     }
-    return 0;
+
+    snd_mixer_selem_id_t* id;
+    snd_mixer_selem_id_alloca(&id);
+    snd_mixer_selem_id_set_index(id, 0);
+    snd_mixer_selem_id_set_name(id, "Master");
+    return snd_mixer_find_selem(alsaMixer, id);
 }
 
 void AudioManager::pulseStateChanged(pa_context *c, void *userdata) {
     AudioManager* currentManager = (AudioManager*) userdata;
     switch (pa_context_get_state(c)) {
         case PA_CONTEXT_READY:
+            currentManager->pulseAvailable = true;
             pa_context_set_subscribe_callback(c, &AudioManager::pulseSubscribe, currentManager);
-            pa_context_subscribe(c, (pa_subscription_mask_t) (PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE | PA_SUBSCRIPTION_MASK_SINK_INPUT | PA_SUBSCRIPTION_MASK_CLIENT), NULL, userdata);
+            pa_context_subscribe(c, (pa_subscription_mask_t) (PA_SUBSCRIPTION_MASK_SERVER | PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SINK_INPUT | PA_SUBSCRIPTION_MASK_CLIENT), NULL, userdata);
+
+            //Load everything once; after this, only the objects named in subscription events are fetched
             pa_context_get_server_info(c, &AudioManager::pulseServerInfo, currentManager);
             pa_context_get_sink_info_list(c, &AudioManager::pulseGetSinks, currentManager);
-            pa_context_get_source_info_list(c, &AudioManager::pulseGetSources, currentManager);
-            pa_context_get_sink_input_info_list(c, &AudioManager::pulseGetInputSinks, currentManager);
             pa_context_get_client_info_list(c, &AudioManager::pulseGetClients, currentManager);
+            pa_context_get_sink_input_info_list(c, &AudioManager::pulseGetInputSinks, currentManager);
+            break;
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
+            //Fall back to ALSA
+            currentManager->pulseAvailable = false;
+            break;
+        default:
+            break;
     }
 }
 
 void AudioManager::pulseSubscribe(pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *userdata) {
     AudioManager* currentManager = (AudioManager*) userdata;
+    bool removed = (t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE;
     switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
-        case PA_SUBSCRIPTION_EVENT_SINK:
+        case PA_SUBSCRIPTION_EVENT_SERVER:
             pa_context_get_server_info(c, &AudioManager::pulseServerInfo, currentManager);
-            pa_context_get_sink_info_list(c, &AudioManager::pulseGetSinks, currentManager);
             break;
-        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
-            pa_context_get_sink_input_info_list(c, &AudioManager::pulseGetInputSinks, currentManager);
+        case PA_SUBSCRIPTION_EVENT_SINK:
+            if (removed) {
+                if (currentManager->sinks.contains(index)) {
+                    bool wasDefault = (int) index == currentManager->defaultSinkIndex;
+                    AudioSink sink = currentManager->sinks.take(index);
+                    currentManager->updateDefaultSink();
+                    currentManager->sinkRemoved(sink, wasDefault);
+                }
+            } else {
+                pa_context_get_sink_info_by_index(c, index, &AudioManager::pulseGetSinks, currentManager);
+            }
             break;
-        case PA_SUBSCRIPTION_EVENT_SOURCE:
-            pa_context_get_server_info(c, &AudioManager::pulseServerInfo, currentManager);
-            pa_context_get_source_info_list(c, &AudioManager::pulseGetSources, currentManager);
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
+            if (removed) {
+                currentManager->removeStream(index);
+            } else {
+                pa_context_get_sink_input_info(c, index, &AudioManager::pulseGetInputSinks, currentManager);
+            }
             break;
         case PA_SUBSCRIPTION_EVENT_CLIENT:
-            pa_context_get_client_info_list(c, &AudioManager::pulseGetClients, currentManager);
+            if (removed) {
+                currentManager->tsClientIndices.removeAll(index);
+            } else {
+                pa_context_get_client_info(c, index, &AudioManager::pulseGetClients, currentManager);
+            }
     }
 }
 
 void AudioManager::pulseGetSinks(pa_context *c, const pa_sink_info *i, int eol, void *userdata) {
+    Q_UNUSED(c)
+    AudioManager* currentManager = (AudioManager*) userdata;
+    if (eol == 0) {
+        bool isNew = !currentManager->sinks.contains(i->index);
+
+        AudioSink sink;
+        sink.index = i->index;
+        sink.name = QString::fromUtf8(i->name);
+        sink.type = sinkType(i);
+        sink.volume = i->volume;
+        sink.muted = i->mute;
+        currentManager->sinks.insert(i->index, sink);
+
+        if (sink.name == currentManager->defaultSinkName) currentManager->updateDefaultSink();
 
+        //Sinks that were already there when we started aren't hotplugged
+        if (isNew && currentManager->sinksLoaded) currentManager->sinkAdded(sink);
+    } else {
+        currentManager->sinksLoaded = true;
+    }
 }
 
-void AudioManager::pulseServerInfo(pa_context *c, const pa_server_info *i, void *userdata) {
-    pa_context_get_sink_info_by_name(c, i->default_sink_name, &AudioManager::pulseGetDefaultSink, userdata);
+QString AudioManager::sinkType(const pa_sink_info* i) {
+    QString bus = QString::fromUtf8(pa_proplist_gets(i->proplist, PA_PROP_DEVICE_BUS));
+    QString formFactor = QString::fromUtf8(pa_proplist_gets(i->proplist, PA_PROP_DEVICE_FORM_FACTOR));
+    QString port = i->active_port == nullptr ? "" : QString::fromUtf8(i->active_port->name);
+
+    if (bus == "bluetooth") return "bluetooth";
+    if (bus == "usb") return "usb";
+    if (port.contains("hdmi") || port.contains("iec958")) return "hdmi";
+    if (port.contains("headphones") || formFactor == "headphone" || formFactor == "headset") return "headphones";
+    return "internal";
 }
 
-void AudioManager::pulseGetDefaultSink(pa_context *c, const pa_sink_info *i, int eol, void *userdata) {
-    if (eol == 0) {
-        AudioManager* currentManager = (AudioManager*) userdata;
-        currentManager->defaultSinkIndex = i->index;
-        currentManager->defaultSinkVolume = i->volume;
+int AudioManager::sinkPriority(QString type) {
+    //Lower is better; unknown types go last
+    QStringList priorities = settings.value("sound/hotplug/priority", QStringList({"bluetooth", "usb", "headphones", "hdmi", "internal"})).toStringList();
+    int priority = priorities.indexOf(type);
+    return priority == -1 ? priorities.count() : priority;
+}
+
+void AudioManager::sinkAdded(const AudioSink& sink) {
+    recentSinks.removeAll(sink.name);
+    recentSinks.prepend(sink.name);
+    if (!settings.value("sound/hotplug/switchToNew", true).toBool()) return;
+
+    //Prefer the newly connected device unless the current output is a better kind of device
+    if (sinks.contains(defaultSinkIndex) && sinkPriority(sinks.value(defaultSinkIndex).type) < sinkPriority(sink.type)) return;
+    switchToSink(sink);
+}
+
+void AudioManager::sinkRemoved(const AudioSink& sink, bool wasDefault) {
+    recentSinks.removeAll(sink.name);
+    if (!wasDefault) return;
+
+    if (settings.value("sound/hotplug/pauseOnRemoval", true).toBool()) {
+        //Don't let music suddenly start coming out of the speakers
+        pausePlayersOnSink(sink.index);
+    }
+
+    if (sinks.isEmpty()) return;
+
+    //Fall back to the most recently connected device that's still around, or the best kind of device we have
+    for (QString name : recentSinks) {
+        for (const AudioSink& candidate : sinks) {
+            if (candidate.name == name) {
+                switchToSink(candidate);
+                return;
+            }
+        }
+    }
+
+    AudioSink best = sinks.first();
+    for (const AudioSink& candidate : sinks) {
+        if (sinkPriority(candidate.type) < sinkPriority(best.type)) best = candidate;
+    }
+    switchToSink(best);
+}
+
+void AudioManager::pausePlayersOnSink(quint32 sink) {
+    //PulseAudio may already have moved or dropped the streams, so look at where they just were as well
+    QList<uint> pids;
+    QStringList names;
+    QList<AudioStream> candidates = streams.values() + departedStreams;
+    for (const AudioStream& stream : candidates) {
+        bool wasOnSink = stream.sink == sink || (stream.previousSink == sink && stream.left.isValid() && stream.left.elapsed() < 2000);
+        if (!wasOnSink) continue;
+
+        if (stream.pid != 0) pids.append(stream.pid);
+        if (!stream.application.isEmpty()) names.append(stream.application.toLower());
+        if (!stream.binary.isEmpty()) names.append(stream.binary.toLower());
+    }
+    if (pids.isEmpty() && names.isEmpty()) return;
+
+    for (MprisPlayerPtr player : MprisEngine::players()) {
+        if (player->playbackStatus() != MprisPlayer::Playing) continue;
+
+        if (names.contains(player->identity().toLower()) || names.contains(player->desktopEntry().toLower())) {
+            player->pause();
+            continue;
+        }
+
+        //Otherwise, see if the player is the process that was playing on the sink
+        QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().interface()->asyncCall("GetConnectionUnixProcessID", player->service()), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+            QDBusPendingReply<uint> reply = *watcher;
+            if (!reply.isError() && pids.contains(reply.value()) && player->playbackStatus() == MprisPlayer::Playing) player->pause();
+            watcher->deleteLater();
+        });
     }
 }
 
-void AudioManager::pulseGetSources(pa_context *c, const pa_source_info *i, int eol, void *userdata) {
+void AudioManager::switchToSink(const AudioSink& sink) {
+    pa_context_set_default_sink(pulseContext, sink.name.toUtf8().constData(), NULL, NULL);
+
+    //Update straight away so stream moves below aren't mistaken for the user picking an output
+    defaultSinkName = sink.name;
+    updateDefaultSink();
+
+    if (!settings.value("sound/hotplug/moveStreams", true).toBool()) return;
+    for (const AudioStream& stream : streams) {
+        if (stream.sink == sink.index) continue;
+
+        //Leave applications that the user deliberately sent somewhere else alone
+        if (!stream.application.isEmpty() && !settings.value("sound/applications/" + stream.application + "/sink").toString().isEmpty()) continue;
+        pa_context_move_sink_input_by_index(pulseContext, stream.index, sink.index, NULL, NULL);
+    }
+}
+
+void AudioManager::pulseServerInfo(pa_context *c, const pa_server_info *i, void *userdata) {
+    Q_UNUSED(c)
     AudioManager* currentManager = (AudioManager*) userdata;
-    if (eol == 0) {
+    currentManager->defaultSinkName = QString::fromUtf8(i->default_sink_name);
+    currentManager->updateDefaultSink();
+}
+
+void AudioManager::updateDefaultSink() {
+    for (const AudioSink& sink : sinks) {
+        if (sink.name == defaultSinkName) {
+            defaultSinkIndex = sink.index;
+            defaultSinkVolume = sink.volume;
+            return;
+        }
+    }
 
+    //The default sink hasn't been loaded yet, or it's gone
+    defaultSinkIndex = -1;
+}
+
+void AudioManager::removeStream(quint32 index) {
+    //Remember where departed streams were playing for a moment, in case their sink is going away too
+    for (int i = departedStreams.count() - 1; i >= 0; i--) {
+        if (departedStreams.at(i).left.elapsed() > 2000) departedStreams.removeAt(i);
+    }
+    if (streams.contains(index)) {
+        AudioStream stream = streams.take(index);
+        stream.previousSink = stream.sink;
+        stream.sink = PA_INVALID_INDEX;
+        stream.left.start();
+        departedStreams.append(stream);
     }
+
+    originalStreamVolumes.remove(index);
+    sentStreamVolumes.remove(index);
 }
 
 void AudioManager::attenuateStreams() {
     if (pulseAvailable) {
-        if (attenuateRequests == 0) {
-            for (int source : originalStreamVolumes.keys()) {
-                //Set volume to 50% of original
-                pa_cvolume originalVolume = originalStreamVolumes.value(source);
-                for (int i = 0; i < originalVolume.channels; i++) {
-                    if (originalVolume.values[i] > PA_VOLUME_NORM) {
-                        originalVolume.values[i] = PA_VOLUME_NORM / 2;
-                    } else {
-                        originalVolume.values[i] /= 2;
-                    }
-                }
-                pa_context_set_sink_input_volume(pulseContext, source, &originalVolume, NULL, NULL);
-            }
-            attenuateMode = true;
-        }
-        attenuateRequests++;
+        duckRequests++;
+        updateDuckTarget();
     }
 }
 
 void AudioManager::silenceStreams() {
     if (pulseAvailable) {
-        for (int source : originalStreamVolumes.keys()) {
-            //Set volume to 10% of original
-            pa_cvolume originalVolume = originalStreamVolumes.value(source);
-            for (int i = 0; i < originalVolume.channels; i++) {
-                originalVolume.values[i] /= 10;
-            }
-            pa_context_set_sink_input_volume(pulseContext, source, &originalVolume, NULL, NULL);
-        }
-        attenuateMode = true;
+        silenceRequests++;
+        updateDuckTarget();
     }
 }
 
 void AudioManager::restoreStreams(bool immediate) {
-    if (pulseAvailable) {
-        attenuateRequests--;
-        if (attenuateRequests == 0) {
-            //Sounds much better if we delay by a second
-            QTimer::singleShot(immediate ? 0 : 1000, [=]() {
-                for (int source : originalStreamVolumes.keys()) {
-                    //Restore volume of each stream
-                    pa_cvolume originalVolume = originalStreamVolumes.value(source);
-                    if (originalVolume.channels > 0) {
-                        tVariantAnimation* anim = new tVariantAnimation;
-                        anim->setStartValue(originalVolume.values[0] / 2);
-                        pa_volume_t endValue = originalVolume.values[0];
-                        if (endValue > PA_VOLUME_NORM) {
-                            endValue = PA_VOLUME_NORM;
-                        }
-                        anim->setEndValue(endValue);
-                        anim->setDuration(500);
-                        connect(anim, &tVariantAnimation::valueChanged, [=](QVariant value) {
-                            pa_cvolume originalVolume = originalStreamVolumes.value(source);
-                            for (int i = 0; i < originalVolume.channels; i++) {
-                                originalVolume.values[i] = value.toUInt();
-                            }
-                            pa_context_set_sink_input_volume(pulseContext, source, &originalVolume, NULL, NULL);
-                        });
-                        connect(anim, &tVariantAnimation::finished, [=]() {
-                            attenuateMode = false;
-                        });
-                        connect(anim, SIGNAL(finished()), anim, SLOT(deleteLater()));
-                        anim->start();
-                    }
+    if (pulseAvailable) releaseStreams(duckRequests, immediate);
+}
 
-                }
-            });
-        } else if (attenuateRequests == -1) {
-            attenuateRequests = 0;
+void AudioManager::unsilenceStreams(bool immediate) {
+    if (pulseAvailable) releaseStreams(silenceRequests, immediate);
+}
+
+void AudioManager::releaseStreams(int& requests, bool immediate) {
+    //Each restore releases one request of its own kind, so overlapping requests can never leave streams attenuated
+    if (requests > 0) requests--;
+
+    if (silenceRequests == 0 && duckRequests == 0 && !immediate) {
+        restoreDelayTimer->start();
+    } else {
+        updateDuckTarget();
+    }
+}
+
+void AudioManager::updateDuckTarget() {
+    restoreDelayTimer->stop();
+
+    double target = 1;
+    if (silenceRequests > 0) {
+        target = 0.1;
+    } else if (duckRequests > 0) {
+        target = 0.5;
+    }
+    if (qFuzzyCompare(target, duckTarget)) return;
+
+    //Duck quickly, but fade back in gently
+    duckFrom = duckLevel;
+    duckTarget = target;
+    duckDuration = target < duckLevel ? 100 : 500;
+    duckClock.start();
+    duckTimer->start();
+    duckTick();
+}
+
+void AudioManager::duckTick() {
+    double progress = qMin(1.0, duckClock.elapsed() / (double) duckDuration);
+    duckLevel = duckFrom + (duckTarget - duckFrom) * progress;
+    if (progress >= 1) {
+        duckLevel = duckTarget;
+        duckTimer->stop();
+    }
+
+    for (int stream : originalStreamVolumes.keys()) {
+        applyDuckLevel(stream);
+    }
+}
+
+void AudioManager::applyDuckLevel(int stream) {
+    pa_cvolume volume = originalStreamVolumes.value(stream);
+    if (duckLevel < 1) {
+        for (int i = 0; i < volume.channels; i++) {
+            volume.values[i] = (pa_volume_t) (volume.values[i] * duckLevel);
         }
     }
+
+    //Skip streams that are already at this volume
+    QList<pa_cvolume>& sent = sentStreamVolumes[stream];
+    if (!sent.isEmpty() && pa_cvolume_equal(&sent.last(), &volume)) return;
+
+    //Echoes that never came back shouldn't pile up
+    sent.append(volume);
+    while (sent.count() > 16) sent.removeFirst();
+    pa_context_set_sink_input_volume(pulseContext, stream, &volume, NULL, NULL);
+}
+
+bool AudioManager::isDuckEcho(int stream, const pa_cvolume& volume) {
+    //PulseAudio reports volumes in the order we set them, so anything older than a match has been superseded
+    QList<pa_cvolume>& sent = sentStreamVolumes[stream];
+    for (int i = sent.count() - 1; i >= 0; i--) {
+        if (pa_cvolume_equal(&sent.at(i), &volume)) {
+            sent.erase(sent.begin(), sent.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioManager::rebaseDuckedStream(int stream, const pa_cvolume& volume) {
+    //The user set this volume while we had the stream ducked, so it's what the stream should be
+    //at the current level; work out what that means once the stream is back to full volume
+    pa_cvolume original = volume;
+    if (duckLevel < 1) {
+        for (int i = 0; i < original.channels; i++) {
+            original.values[i] = (pa_volume_t) qMin<double>(PA_VOLUME_MAX, volume.values[i] / duckLevel);
+        }
+    }
+    originalStreamVolumes.insert(stream, original);
+    sentStreamVolumes.insert(stream, {volume});
 }
 
 void AudioManager::pulseGetInputSinks(pa_context *c, const pa_sink_input_info *i, int eol, void *userdata) {
+    Q_UNUSED(c)
     AudioManager* currentManager = (AudioManager*) userdata;
     if (eol == 0) {
-        if (!currentManager->tsClientIndices.contains(i->client)) {
-            if (currentManager->attenuateMode) {
-                if (currentManager->originalStreamVolumes.contains(i->index)) {
-                    pa_cvolume originalVolume = i->volume;
-                    for (int i = 0; i < originalVolume.channels; i++) {
-                        originalVolume.values[i] = originalVolume.values[i] * 2;
-                    }
-                    currentManager->originalStreamVolumes.insert(i->index, originalVolume);
-                } else {
-                    currentManager->originalStreamVolumes.insert(i->index, i->volume);
-                }
-            } else {
-                currentManager->originalStreamVolumes.insert(i->index, i->volume);
+        bool isNew = !currentManager->streams.contains(i->index);
+
+        AudioStream stream, old;
+        if (!isNew) {
+            //Remember which sink it was moved away from
+            old = currentManager->streams.value(i->index);
+            stream.previousSink = old.previousSink;
+            stream.left = old.left;
+            if (old.sink != i->sink) {
+                stream.previousSink = old.sink;
+                stream.left.start();
+            }
+        }
+        stream.index = i->index;
+        stream.client = i->client;
+        stream.sink = i->sink;
+        stream.volume = i->volume;
+        stream.channelMap = i->channel_map;
+        stream.muted = i->mute;
+        stream.application = applicationKey(i);
+        stream.binary = QString::fromUtf8(pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_PROCESS_BINARY));
+        stream.pid = QString::fromUtf8(pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_PROCESS_ID)).toUInt();
+        currentManager->streams.insert(i->index, stream);
+
+        bool ownStream = currentManager->tsClientIndices.contains(i->client);
+        bool remember = !ownStream && !stream.application.isEmpty() && currentManager->settings.value("sound/rememberApplications", true).toBool();
+        if (isNew && remember) {
+            //Put the stream back where the user last had this application, before it gets far into playback
+            currentManager->restoreApplicationPreferences(i, stream.application);
+        }
+
+        bool userChange = false;
+        if (!ownStream) {
+            if (!currentManager->originalStreamVolumes.contains(i->index)) {
+                //New stream; bring it down with the others if we're ducking
+                //Until the volume we restored comes back, reports of the volume it started at aren't the user's doing either
+                pa_cvolume volume = currentManager->streams.value(i->index).volume;
+                currentManager->originalStreamVolumes.insert(i->index, volume);
+                currentManager->sentStreamVolumes.insert(i->index, {i->volume, volume});
+                if (currentManager->duckLevel < 1) currentManager->applyDuckLevel(i->index);
+            } else if (!currentManager->isDuckEcho(i->index, i->volume)) {
+                //Not a volume we set, so the user changed it
+                currentManager->rebaseDuckedStream(i->index, i->volume);
+                userChange = true;
+            }
+        }
+
+        if (!isNew && remember && (userChange || old.muted != stream.muted || old.sink != stream.sink)) {
+            //Remember the volume the stream goes back to, not however far we've ducked it
+            AudioStream saved = stream;
+            saved.volume = currentManager->originalStreamVolumes.value(i->index, stream.volume);
+            currentManager->saveApplicationPreferences(saved);
+        }
+    }
+}
+
+QString AudioManager::applicationKey(const pa_sink_input_info* i) {
+    const char* application = pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_NAME);
+    if (application == nullptr) application = pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_PROCESS_BINARY);
+    if (application == nullptr) return "";
+
+    //Keep the key usable as a settings group
+    return QString::fromUtf8(application).replace("/", "_");
+}
+
+void AudioManager::restoreApplicationPreferences(const pa_sink_input_info* i, QString application) {
+    settings.beginGroup("sound/applications/" + application);
+    QStringList volumes = settings.value("volumes").toStringList();
+    QString channelMap = settings.value("channelMap").toStringList().join(",");
+    bool hasAverageVolume = settings.contains("volume");
+    pa_volume_t averageVolume = settings.value("volume").toUInt();
+    bool hasMuted = settings.contains("muted");
+    bool muted = settings.value("muted").toBool();
+    QString sink = settings.value("sink").toString();
+    settings.endGroup();
+
+    //Put each channel back where it was, so the balance survives as well as the level
+    pa_cvolume newVolume;
+    pa_cvolume_init(&newVolume);
+    pa_channel_map savedMap;
+    if (!volumes.isEmpty() && volumes.count() <= PA_CHANNELS_MAX && pa_channel_map_parse(&savedMap, channelMap.toUtf8().constData()) != nullptr && savedMap.channels == volumes.count()) {
+        newVolume.channels = static_cast<uint8_t>(volumes.count());
+        for (int c = 0; c < volumes.count(); c++) {
+            newVolume.values[c] = volumes.at(c).toUInt();
+        }
+        pa_cvolume_remap(&newVolume, &savedMap, &i->channel_map);
+    } else if (hasAverageVolume) {
+        //Saved before we kept every channel
+        pa_cvolume_set(&newVolume, i->volume.channels, averageVolume);
+    }
+
+    if (pa_cvolume_valid(&newVolume) && !pa_cvolume_equal(&newVolume, &i->volume)) {
+        pa_context_set_sink_input_volume(pulseContext, i->index, &newVolume, NULL, NULL);
+        streams[i->index].volume = newVolume;
+    }
+
+    if (hasMuted && muted != (bool) i->mute) {
+        pa_context_set_sink_input_mute(pulseContext, i->index, muted, NULL, NULL);
+        streams[i->index].muted = muted;
+    }
+
+    if (!sink.isEmpty()) {
+        //Only move the stream if that output is still around
+        for (const AudioSink& s : sinks) {
+            if (s.name == sink && s.index != i->sink) {
+                pa_context_move_sink_input_by_index(pulseContext, i->index, s.index, NULL, NULL);
+                break;
             }
         }
     }
 }
 
+void AudioManager::saveApplicationPreferences(const AudioStream& stream) {
+    //An empty sink means the application follows the default output
+    QString sink;
+    if (sinks.contains(stream.sink) && sinks.value(stream.sink).name != defaultSinkName) sink = sinks.value(stream.sink).name;
+
+    QStringList volumes;
+    for (int c = 0; c < stream.volume.channels; c++) {
+        volumes.append(QString::number(stream.volume.values[c]));
+    }
+    char channelMap[PA_CHANNEL_MAP_SNPRINT_MAX];
+    pa_channel_map_snprint(channelMap, sizeof(channelMap), &stream.channelMap);
+
+    settings.beginGroup("sound/applications/" + stream.application);
+    if (settings.value("volumes").toStringList() != volumes) settings.setValue("volumes", volumes);
+    if (settings.value("channelMap").toStringList().join(",") != channelMap) settings.setValue("channelMap", QString(channelMap));
+    if (settings.contains("volume")) settings.remove("volume");
+    if (settings.value("muted").toBool() != stream.muted || !settings.contains("muted")) settings.setValue("muted", stream.muted);
+    if (settings.value("sink").toString() != sink) settings.setValue("sink", sink);
+    settings.endGroup();
+}
+
 void AudioManager::pulseGetClients(pa_context *c, const pa_client_info *i, int eol, void *userdata) {
+    Q_UNUSED(c)
     AudioManager* currentManager = (AudioManager*) userdata;
     if (eol == 0) {
-        if (QString::fromUtf8(i->name).toLower().contains("theshell") || QString::fromUtf8(i->name).toLower().contains("qtpulseaudio")) {
-            currentManager->newTsClientIndices.append(i->index);
+        //Our own sounds shouldn't be ducked
+        QString name = QString::fromUtf8(i->name).toLower();
+        if (name.contains("theshell") || name.contains("qtpulseaudio")) {
+            if (!currentManager->tsClientIndices.contains(i->index)) currentManager->tsClientIndices.append(i->index);
+        } else {
+            currentManager->tsClientIndices.removeAll(i->index);
         }
-    } else {
-        currentManager->tsClientIndices = currentManager->newTsClientIndices;
-        currentManager->newTsClientIndices.clear();
     }
 }
-
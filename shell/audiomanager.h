@@ -22,11 +22,11 @@
 #define AUDIOMANAGER_H
 
 #include <QObject>
-#include <QProcess>
 #include <QMap>
 #include <QTimer>
 #include <QDateTime>
-#include <tvariantanimation.h>
+#include <QElapsedTimer>
+#include <QSettings>
 #include <pulse/context.h>
 #include <pulse/glib-mainloop.h>
 #include <pulse/volume.h>
@@ -34,6 +34,33 @@
 #include <pulse/subscribe.h>
 #include <pulse/stream.h>
 
+typedef struct _snd_mixer snd_mixer_t;
+typedef struct _snd_mixer_elem snd_mixer_elem_t;
+
+struct AudioSink {
+    quint32 index;
+    QString name;
+    QString type;
+    pa_cvolume volume;
+    bool muted;
+};
+
+struct AudioStream {
+    quint32 index;
+    quint32 client;
+    quint32 sink;
+    pa_cvolume volume;
+    pa_channel_map channelMap;
+    bool muted;
+    QString application;
+    QString binary;
+    uint pid;
+
+    //The sink this stream was last moved away from, or played on before it went away
+    quint32 previousSink = PA_INVALID_INDEX;
+    QElapsedTimer left;
+};
+
 class AudioManager : public QObject
 {
     Q_OBJECT
@@ -48,6 +75,7 @@ public slots:
     void attenuateStreams();
     void silenceStreams();
     void restoreStreams(bool immediate = false);
+    void unsilenceStreams(bool immediate = false);
 
 private:
     pa_context* pulseContext = NULL;
@@ -55,23 +83,65 @@ private:
 
     static void pulseStateChanged(pa_context *c, void *userdata);
     static void pulseGetSinks(pa_context *c, const pa_sink_info *i, int eol, void *userdata);
-    static void pulseGetDefaultSink(pa_context *c, const pa_sink_info *i, int eol, void *userdata);
     static void pulseSubscribe(pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *userdata);
     static void pulseServerInfo(pa_context *c, const pa_server_info *i, void *userdata);
-    static void pulseGetSources(pa_context *c, const pa_source_info *i, int eol, void *userdata);
     static void pulseGetInputSinks(pa_context *c, const pa_sink_input_info *i, int eol, void *userdata);
     static void pulseGetClients(pa_context *c, const pa_client_info*i, int eol, void *userdata);
 
+    void updateDefaultSink();
+    void removeStream(quint32 index);
+
+    static QString sinkType(const pa_sink_info* i);
+    int sinkPriority(QString type);
+    void sinkAdded(const AudioSink& sink);
+    void sinkRemoved(const AudioSink& sink, bool wasDefault);
+    void switchToSink(const AudioSink& sink);
+    void pausePlayersOnSink(quint32 sink);
+
+    static QString applicationKey(const pa_sink_input_info* i);
+    void restoreApplicationPreferences(const pa_sink_input_info* i, QString application);
+    void saveApplicationPreferences(const AudioStream& stream);
+
+    snd_mixer_elem_t* alsaMasterElement();
+
+    void releaseStreams(int& requests, bool immediate);
+    void updateDuckTarget();
+    void duckTick();
+    void applyDuckLevel(int stream);
+    bool isDuckEcho(int stream, const pa_cvolume& volume);
+    void rebaseDuckedStream(int stream, const pa_cvolume& volume);
+
     QMap<int, pa_cvolume> originalStreamVolumes;
-    int attenuateRequests = 0;
+
+    //Volumes we've set on each stream that PulseAudio may still report back, oldest first
+    QMap<int, QList<pa_cvolume>> sentStreamVolumes;
+    int duckRequests = 0;
+    int silenceRequests = 0;
+
+    //One ramp drives every stream; the level is the fraction of each stream's original volume
+    double duckLevel = 1;
+    double duckFrom = 1;
+    double duckTarget = 1;
+    int duckDuration = 0;
+    QElapsedTimer duckClock;
+    QTimer* duckTimer;
+    QTimer* restoreDelayTimer;
+
+    //Mirror of the PulseAudio objects we care about, kept up to date from subscription events
+    QMap<quint32, AudioSink> sinks;
+    QMap<quint32, AudioStream> streams;
+    QList<AudioStream> departedStreams;
+    QString defaultSinkName;
+    QStringList recentSinks;
+    bool sinksLoaded = false;
 
     bool pulseAvailable = false;
-    bool attenuateMode = false;
     int defaultSinkIndex = -1;
     QList<uint> tsClientIndices;
-    QList<uint> newTsClientIndices;
     pa_cvolume defaultSinkVolume;
     QSettings settings;
+
+    snd_mixer_t* alsaMixer = nullptr;
 };
 
 #endif // AUDIOMANAGER_H
@@ -0,0 +1,327 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#include "gesturerecognizer.h"
+
+#include <QtMath>
+
+struct GestureRecognizerTouch {
+    quint32 id;
+    bool active = false;
+
+    QPointF start;
+    QPointF current;
+};
+
+struct GestureRecognizerPrivate {
+    enum State {
+        Idle,
+        Possible,
+        Recognized,
+        Done
+    };
+
+    //Touch slots are fixed so that recognition never allocates while events are coming in
+    GestureRecognizerTouch touches[GestureRecognizer::MaxTouches];
+    int touchCount = 0;
+    int maxFingers = 0;
+
+    State state = Idle;
+    GestureRecognizer::Direction edge = GestureRecognizer::NoDirection;
+    GestureRecognizer::Gesture gesture;
+
+    QRectF screenGeometry;
+    qreal edgeMargin = 20;
+    qreal swipeDistance = 200;
+    qreal pinchScale = 0.3;
+
+    QPointF centroid(bool current) {
+        QPointF sum;
+        int count = 0;
+        for (const GestureRecognizerTouch& touch : touches) {
+            if (!touch.active) continue;
+            sum += current ? touch.current : touch.start;
+            count++;
+        }
+        return count == 0 ? QPointF() : sum / count;
+    }
+
+    qreal spread(bool current) {
+        QPointF centre = centroid(current);
+        qreal sum = 0;
+        int count = 0;
+        for (const GestureRecognizerTouch& touch : touches) {
+            if (!touch.active) continue;
+            QPointF delta = (current ? touch.current : touch.start) - centre;
+            sum += qSqrt(QPointF::dotProduct(delta, delta));
+            count++;
+        }
+        return count == 0 ? 0 : sum / count;
+    }
+
+    GestureRecognizerTouch* touch(quint32 id) {
+        for (GestureRecognizerTouch& touch : touches) {
+            if (touch.active && touch.id == id) return &touch;
+        }
+        return nullptr;
+    }
+
+    //Distance travelled by the centroid in the direction of the gesture
+    qreal travel(GestureRecognizer::Direction direction) {
+        QPointF delta = centroid(true) - centroid(false);
+        switch (direction) {
+            case GestureRecognizer::Left:
+                return -delta.x();
+            case GestureRecognizer::Right:
+                return delta.x();
+            case GestureRecognizer::Up:
+                return -delta.y();
+            case GestureRecognizer::Down:
+                return delta.y();
+            default:
+                return 0;
+        }
+    }
+};
+
+GestureRecognizer::GestureRecognizer(QObject *parent) : QObject(parent)
+{
+    d = new GestureRecognizerPrivate();
+}
+
+GestureRecognizer::~GestureRecognizer()
+{
+    delete d;
+}
+
+QString GestureRecognizer::Gesture::name() const
+{
+    QString direction;
+    switch (this->direction) {
+        case Left: direction = "left"; break;
+        case Right: direction = "right"; break;
+        case Up: direction = "up"; break;
+        case Down: direction = "down"; break;
+        case In: direction = "in"; break;
+        case Out: direction = "out"; break;
+        case NoDirection: return "";
+    }
+
+    switch (type) {
+        case EdgeSwipe: {
+            //Edge swipes are named after the edge they start from
+            switch (this->direction) {
+                case Right: return "edge-left";
+                case Left: return "edge-right";
+                case Down: return "edge-top";
+                case Up: return "edge-bottom";
+                default: return "";
+            }
+        }
+        case Swipe:
+            return "swipe-" + direction;
+        case Pinch:
+            return "pinch-" + direction;
+        case NoGesture:
+            return "";
+    }
+    return "";
+}
+
+void GestureRecognizer::setScreenGeometry(QRectF geometry)
+{
+    d->screenGeometry = geometry;
+}
+
+void GestureRecognizer::setEdgeMargin(qreal margin)
+{
+    d->edgeMargin = margin;
+}
+
+qreal GestureRecognizer::edgeMargin()
+{
+    return d->edgeMargin;
+}
+
+void GestureRecognizer::setSwipeDistance(qreal distance)
+{
+    d->swipeDistance = distance;
+}
+
+void GestureRecognizer::setPinchScale(qreal scale)
+{
+    d->pinchScale = scale;
+}
+
+void GestureRecognizer::touchBegin(quint32 id, QPointF position)
+{
+    if (d->state == GestureRecognizerPrivate::Idle) {
+        d->state = GestureRecognizerPrivate::Possible;
+        d->maxFingers = 0;
+        d->edge = edgeDirection(position, d->screenGeometry);
+        d->gesture = Gesture();
+    }
+
+    d->touchCount++;
+    if (d->state != GestureRecognizerPrivate::Possible) return; //Late fingers don't take part
+
+    GestureRecognizerTouch* slot = nullptr;
+    for (GestureRecognizerTouch& touch : d->touches) {
+        if (!touch.active) {
+            slot = &touch;
+            break;
+        }
+    }
+
+    if (slot == nullptr) {
+        //More fingers than we can track; this isn't a gesture
+        d->state = GestureRecognizerPrivate::Done;
+        return;
+    }
+
+    slot->id = id;
+    slot->active = true;
+    slot->start = position;
+    slot->current = position;
+    d->maxFingers = qMax(d->maxFingers, d->touchCount);
+}
+
+void GestureRecognizer::touchUpdate(quint32 id, QPointF position)
+{
+    GestureRecognizerTouch* touch = d->touch(id);
+    if (touch == nullptr) return;
+    touch->current = position;
+
+    if (d->state == GestureRecognizerPrivate::Possible) {
+        evaluate();
+    } else if (d->state == GestureRecognizerPrivate::Recognized) {
+        updateProgress();
+        emit gestureUpdated(d->gesture);
+    }
+}
+
+void GestureRecognizer::touchEnd(quint32 id)
+{
+    if (d->touchCount > 0) d->touchCount--;
+
+    GestureRecognizerTouch* touch = d->touch(id);
+    if (touch != nullptr) {
+        if (d->state == GestureRecognizerPrivate::Recognized) {
+            //The gesture ends as soon as the first finger comes up
+            emit gestureFinished(d->gesture);
+        }
+        touch->active = false;
+        if (d->state != GestureRecognizerPrivate::Idle) d->state = GestureRecognizerPrivate::Done;
+    }
+
+    if (d->touchCount == 0) {
+        for (GestureRecognizerTouch& touch : d->touches) {
+            touch.active = false;
+        }
+        d->state = GestureRecognizerPrivate::Idle;
+    }
+}
+
+void GestureRecognizer::reset()
+{
+    if (d->state == GestureRecognizerPrivate::Recognized) emit gestureCancelled(d->gesture);
+
+    for (GestureRecognizerTouch& touch : d->touches) {
+        touch.active = false;
+    }
+    d->touchCount = 0;
+    d->state = GestureRecognizerPrivate::Idle;
+}
+
+bool GestureRecognizer::isTracking(quint32 id)
+{
+    if (d->state != GestureRecognizerPrivate::Possible && d->state != GestureRecognizerPrivate::Recognized) return false;
+    return d->touch(id) != nullptr;
+}
+
+void GestureRecognizer::evaluate()
+{
+    //Gestures are recognized a third of the way through so feedback can start early,
+    //and are only committed once progress reaches 1
+    qreal startDistance = d->swipeDistance / 3;
+    QPointF delta = d->centroid(true) - d->centroid(false);
+    qreal distance = qSqrt(QPointF::dotProduct(delta, delta));
+
+    if (d->maxFingers == 1) {
+        if (d->edge == NoDirection) {
+            //A single finger away from the edges belongs to the application
+            if (distance > startDistance) d->state = GestureRecognizerPrivate::Done;
+        } else if (d->travel(d->edge) > startDistance) {
+            recognize(EdgeSwipe, d->edge);
+        } else if (distance > startDistance) {
+            //Moved along the edge instead of away from it
+            d->state = GestureRecognizerPrivate::Done;
+        }
+    } else if (d->touchCount < MinimumSwipeFingers) {
+        //Two finger scrolling and zooming belongs to the application
+        if (distance > startDistance) d->state = GestureRecognizerPrivate::Done;
+    } else {
+        qreal startSpread = d->spread(false);
+        qreal scale = startSpread == 0 ? 1 : d->spread(true) / startSpread;
+
+        if (qAbs(scale - 1) > d->pinchScale / 3) {
+            recognize(Pinch, scale < 1 ? In : Out);
+        } else if (distance > startDistance) {
+            if (qAbs(delta.x()) > qAbs(delta.y())) {
+                recognize(Swipe, delta.x() < 0 ? Left : Right);
+            } else {
+                recognize(Swipe, delta.y() < 0 ? Up : Down);
+            }
+        }
+    }
+}
+
+void GestureRecognizer::recognize(GestureRecognizer::GestureType type, GestureRecognizer::Direction direction)
+{
+    d->state = GestureRecognizerPrivate::Recognized;
+    d->gesture.type = type;
+    d->gesture.direction = direction;
+    d->gesture.fingers = d->maxFingers;
+    updateProgress();
+    emit gestureStarted(d->gesture);
+}
+
+void GestureRecognizer::updateProgress()
+{
+    d->gesture.position = d->centroid(true);
+    if (d->gesture.type == Pinch) {
+        qreal startSpread = d->spread(false);
+        qreal scale = startSpread == 0 ? 1 : d->spread(true) / startSpread;
+        d->gesture.progress = qMax(0.0, (d->gesture.direction == In ? 1 - scale : scale - 1) / d->pinchScale);
+    } else {
+        d->gesture.progress = qMax(0.0, d->travel(d->gesture.direction) / d->swipeDistance);
+    }
+}
+
+GestureRecognizer::Direction GestureRecognizer::edgeDirection(QPointF position, QRectF screenGeometry)
+{
+    if (screenGeometry.isEmpty()) return NoDirection;
+
+    if (position.x() < screenGeometry.left() + d->edgeMargin) return Right;
+    if (position.x() > screenGeometry.right() - d->edgeMargin) return Left;
+    if (position.y() < screenGeometry.top() + d->edgeMargin) return Down;
+    if (position.y() > screenGeometry.bottom() - d->edgeMargin) return Up;
+    return NoDirection;
+}
@@ -0,0 +1,99 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef GESTURERECOGNIZER_H
+#define GESTURERECOGNIZER_H
+
+#include <QObject>
+#include <QPointF>
+#include <QRectF>
+
+struct GestureRecognizerPrivate;
+class GestureRecognizer : public QObject
+{
+        Q_OBJECT
+    public:
+        explicit GestureRecognizer(QObject *parent = nullptr);
+        ~GestureRecognizer();
+
+        enum GestureType {
+            NoGesture,
+            EdgeSwipe,
+            Swipe,
+            Pinch
+        };
+
+        enum Direction {
+            NoDirection,
+            Left,
+            Right,
+            Up,
+            Down,
+            In,
+            Out
+        };
+
+        struct Gesture {
+            GestureType type = NoGesture;
+            Direction direction = NoDirection;
+            int fingers = 0;
+
+            //Centroid of the fingers taking part in the gesture
+            QPointF position;
+
+            //Reaches 1 once the gesture has travelled far enough to be committed
+            qreal progress = 0;
+
+            QString name() const;
+        };
+
+        static const int MaxTouches = 10;
+        static const int MinimumSwipeFingers = 3;
+
+        void setScreenGeometry(QRectF geometry);
+        void setEdgeMargin(qreal margin);
+        qreal edgeMargin();
+        void setSwipeDistance(qreal distance);
+        void setPinchScale(qreal scale);
+
+        void touchBegin(quint32 id, QPointF position);
+        void touchUpdate(quint32 id, QPointF position);
+        void touchEnd(quint32 id);
+        void reset();
+
+        bool isTracking(quint32 id);
+        Direction edgeDirection(QPointF position, QRectF screenGeometry);
+
+    signals:
+        void gestureStarted(GestureRecognizer::Gesture gesture);
+        void gestureUpdated(GestureRecognizer::Gesture gesture);
+        void gestureFinished(GestureRecognizer::Gesture gesture);
+        void gestureCancelled(GestureRecognizer::Gesture gesture);
+
+    private:
+        GestureRecognizerPrivate* d;
+
+        void evaluate();
+        void recognize(GestureType type, Direction direction);
+        void updateProgress();
+};
+Q_DECLARE_METATYPE(GestureRecognizer::Gesture)
+
+#endif // GESTURERECOGNIZER_H
@@ -30,6 +30,7 @@
 #include "audiomanager.h"
 #include "nativeeventfilter.h"
 #include "dbussignals.h"
+#include "keyboardlayoutmanager.h"
 #include <application.h>
 
 #include <QShortcut>
@@ -40,6 +41,7 @@
 #include <locationdaemon.h>
 #include <powerdaemon.h>
 #include <quietmodedaemon.h>
+#include <actiontracer.h>
 
 #include <Wm/desktopwm.h>
 #include <locale/localemanager.h>
@@ -49,6 +51,7 @@ extern QIcon getIconFromTheme(QString name, QColor textColor);
 extern void EndSession(EndSessionWait::shutdownType type);
 extern QString calculateSize(quint64 size);
 extern AudioManager* AudioMan;
+extern KeyboardLayoutManager* KeyboardLayoutMan;
 extern NativeEventFilter* NativeFilter;
 extern float getDPIScaling();
 extern QDBusServiceWatcher* dbusServiceWatcher;
@@ -492,7 +495,14 @@ InfoPaneDropdown::InfoPaneDropdown(WId MainWindowId, QWidget *parent) :
         return retval;
     }))->then([=](QMap<QString, QString> layouts) {
         d->keyboardLayouts = layouts;
-        setKeyboardLayout(d->settings.value("input/currentLayout", "us(basic)").toString());
+        loadNewKeyboardLayoutMenu();
+        emit keyboardLayoutChanged(KeyboardLayoutMan->currentLayout().split("(").first().toUpper());
+    });
+    connect(KeyboardLayoutMan, &KeyboardLayoutManager::layoutsChanged, this, &InfoPaneDropdown::loadNewKeyboardLayoutMenu);
+    connect(KeyboardLayoutMan, &KeyboardLayoutManager::currentLayoutChanged, this, [=](QString layout) {
+        d->settings.setValue("input/currentLayout", layout);
+        loadNewKeyboardLayoutMenu();
+        emit keyboardLayoutChanged(layout.split("(").first().toUpper());
     });
     connect(tVirtualKeyboard::instance(), &tVirtualKeyboard::keyboardVisibleChanged, this, &InfoPaneDropdown::loadNewKeyboardLayoutMenu);
 
@@ -1816,6 +1826,7 @@ void InfoPaneDropdown::paintEvent(QPaintEvent *event) {
         painter.drawLine(0, 0, this->width(), 0);
     }
     event->accept();
+    ActionTracer::markPainted();
 }
 
 void InfoPaneDropdown::on_systemGTK3Theme_currentIndexChanged(int index)
@@ -2042,15 +2053,8 @@ void InfoPaneDropdown::on_LocationAppsList_itemChanged(QListWidgetItem *item)
 }
 
 void InfoPaneDropdown::loadNewKeyboardLayoutMenu() {
-    //Check to see if current keyboard layout is included in list, and if not, select first
-    QString currentLayout = d->settings.value("input/currentLayout", "us(basic)").toString();
-    QStringList currentLayouts = d->settings.value("input/layout", "us(basic)").toString().split(",");
-    if (!currentLayouts.contains(currentLayout)) {
-        setKeyboardLayout(currentLayouts.first());
-        return;
-    }
-
-    QStringList selectedLayouts = d->settings.value("input/layout", "us(basic)").toString().split(",");
+    QString currentLayout = KeyboardLayoutMan->currentLayout();
+    QStringList selectedLayouts = KeyboardLayoutMan->layouts();
     if (selectedLayouts.count() == 1) {
         emit newKeyboardLayoutMenuAvailable(nullptr);
     } else {
@@ -2079,16 +2083,12 @@ void InfoPaneDropdown::loadNewKeyboardLayoutMenu() {
 }
 
 void InfoPaneDropdown::setKeyboardLayout(QString layout) {
-    d->settings.setValue("input/currentLayout", layout);
-    QProcess::startDetached("setxkbmap " + layout);
-    loadNewKeyboardLayoutMenu();
-    emit keyboardLayoutChanged(layout.split("(").first().toUpper());
+    KeyboardLayoutMan->setLayout(layout);
 }
 
 QString InfoPaneDropdown::setNextKeyboardLayout() {
-    QString currentLayout = d->settings.value("input/currentLayout", "us(basic)").toString();
-    QStringList currentLayouts = d->settings.value("input/layout", "us(basic)").toString().split(",");
-    int currentIndex = currentLayouts.indexOf(currentLayout);
+    QStringList currentLayouts = KeyboardLayoutMan->layouts();
+    int currentIndex = currentLayouts.indexOf(KeyboardLayoutMan->currentLayout());
     currentIndex++;
     if (currentIndex == currentLayouts.count()) currentIndex = 0;
 
@@ -2313,7 +2313,7 @@ void InfoPaneDropdown::pluginMessage(QString message, QVariantList args, StatusC
     } else if (message == "register-snack") {
         emit newSnack(args.first().value<QWidget*>());
     } else if (message == "reload-keyboard-layouts") {
-        loadNewKeyboardLayoutMenu();
+        KeyboardLayoutMan->reloadLayouts();
     } else if (message == "set-keyboard-layout") {
         setKeyboardLayout(args.first().toString());
     } else if (message == "show-restart-required") {
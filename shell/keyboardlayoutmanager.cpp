@@ -0,0 +1,180 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#include "keyboardlayoutmanager.h"
+
+#include <QSettings>
+#include <QProcess>
+#include <QHash>
+#include <QX11Info>
+#include <Wm/desktopwm.h>
+
+#include <X11/XKBlib.h>
+#include <xcb/xkb.h>
+#undef Bool
+#undef Status
+#undef None
+
+struct KeyboardLayoutManagerPrivate {
+    QSettings settings;
+
+    int xkbEventBase = -1;
+
+    //Layouts loaded into the keymap, one per XKB group
+    QStringList layouts;
+    int currentGroup = 0;
+
+    DesktopWmWindow* activeWindow = nullptr;
+    QHash<DesktopWmWindow*, int> windowGroups;
+};
+
+KeyboardLayoutManager::KeyboardLayoutManager(QObject *parent) : QObject(parent)
+{
+    d = new KeyboardLayoutManagerPrivate();
+
+    int opcode, error, major = XkbMajorVersion, minor = XkbMinorVersion;
+    if (XkbQueryExtension(QX11Info::display(), &opcode, &d->xkbEventBase, &error, &major, &minor)) {
+        //We only care about the locked group; Qt already asks for the rest of the state
+        XkbSelectEventDetails(QX11Info::display(), XkbUseCoreKbd, XkbStateNotify, XkbGroupLockMask, XkbGroupLockMask);
+    } else {
+        d->xkbEventBase = -1;
+    }
+
+    connect(DesktopWm::instance(), &DesktopWm::activeWindowChanged, this, &KeyboardLayoutManager::activeWindowChanged);
+    d->activeWindow = DesktopWm::activeWindow();
+
+    reloadLayouts();
+}
+
+KeyboardLayoutManager::~KeyboardLayoutManager()
+{
+    delete d;
+}
+
+QStringList KeyboardLayoutManager::layouts()
+{
+    return d->layouts;
+}
+
+QString KeyboardLayoutManager::currentLayout()
+{
+    return d->layouts.value(d->currentGroup);
+}
+
+void KeyboardLayoutManager::reloadLayouts()
+{
+    //XKB can only hold a limited number of groups in a keymap
+    QStringList layouts = d->settings.value("input/layout", "us(basic)").toString().split(",").mid(0, XkbNumKbdGroups);
+    if (layouts == d->layouts) return;
+
+    d->layouts = layouts;
+    d->windowGroups.clear();
+
+    //Load every layout into the keymap at once so switching is only a group change
+    QStringList layoutNames, variantNames;
+    for (QString layout : layouts) {
+        QStringList parts = layout.split("(");
+        layoutNames.append(parts.first());
+        variantNames.append(parts.count() > 1 ? parts.at(1).chopped(1) : "");
+    }
+
+    QProcess* setxkbmap = new QProcess(this);
+    connect(setxkbmap, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=] {
+        //Loading a keymap resets the locked group
+        d->currentGroup = 0;
+        setLayout(d->settings.value("input/currentLayout", d->layouts.first()).toString());
+        setxkbmap->deleteLater();
+    });
+    setxkbmap->start("setxkbmap", {"-layout", layoutNames.join(","), "-variant", variantNames.join(",")});
+
+    emit layoutsChanged();
+}
+
+void KeyboardLayoutManager::setLayout(QString layout)
+{
+    int group = d->layouts.indexOf(layout);
+    if (group == -1) group = 0;
+
+    if (group == d->currentGroup) {
+        //Nothing changes in the keymap but everyone still needs to know the layout
+        groupChanged(group);
+    } else {
+        lockGroup(group);
+    }
+}
+
+void KeyboardLayoutManager::lockGroup(int group)
+{
+    XkbLockGroup(QX11Info::display(), XkbUseCoreKbd, static_cast<unsigned int>(group));
+    XFlush(QX11Info::display());
+
+    //Don't wait for the state notification to come back to update the bar
+    groupChanged(group);
+}
+
+void KeyboardLayoutManager::groupChanged(int group)
+{
+    if (group < 0 || group >= d->layouts.count()) return;
+
+    d->currentGroup = group;
+    if (d->activeWindow != nullptr) d->windowGroups.insert(d->activeWindow, group);
+    emit currentLayoutChanged(d->layouts.at(group));
+}
+
+bool KeyboardLayoutManager::xkbEvent(xcb_generic_event_t* event)
+{
+    if (d->xkbEventBase == -1 || (event->response_type & ~0x80) != d->xkbEventBase) return false;
+
+    //All XKB events share the same base event; the XKB type is in the second byte
+    if (event->pad0 == XCB_XKB_STATE_NOTIFY) {
+        xcb_xkb_state_notify_event_t* state = reinterpret_cast<xcb_xkb_state_notify_event_t*>(event);
+        if (state->changed & XCB_XKB_STATE_PART_GROUP_LOCK && state->lockedGroup != d->currentGroup) {
+            groupChanged(state->lockedGroup);
+        }
+    }
+    return true;
+}
+
+void KeyboardLayoutManager::activeWindowChanged()
+{
+    DesktopWmWindow* window = DesktopWm::activeWindow();
+    if (window == nullptr || window == d->activeWindow) return;
+
+    if (!d->windowGroups.contains(window)) {
+        connect(window, &DesktopWmWindow::destroyed, this, [=] {
+            d->windowGroups.remove(window);
+            if (d->activeWindow == window) d->activeWindow = nullptr;
+        });
+    }
+
+    d->activeWindow = window;
+    if (!d->settings.value("input/perWindowLayout", true).toBool()) {
+        d->windowGroups.insert(window, d->currentGroup);
+        return;
+    }
+
+    //New windows start out with the first layout
+    int group = d->windowGroups.value(window, 0);
+    if (group != d->currentGroup) {
+        lockGroup(group);
+    } else {
+        d->windowGroups.insert(window, group);
+    }
+}
@@ -0,0 +1,59 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef KEYBOARDLAYOUTMANAGER_H
+#define KEYBOARDLAYOUTMANAGER_H
+
+#include <QObject>
+#include <xcb/xcb.h>
+#include <debuginformationcollector.h>
+
+struct KeyboardLayoutManagerPrivate;
+class KeyboardLayoutManager : public QObject
+{
+        Q_OBJECT
+    public:
+        explicit KeyboardLayoutManager(QObject *parent = T_QOBJECT_ROOT);
+        ~KeyboardLayoutManager();
+
+        QStringList layouts();
+        QString currentLayout();
+
+        bool xkbEvent(xcb_generic_event_t* event);
+
+    signals:
+        void currentLayoutChanged(QString layout);
+        void layoutsChanged();
+
+    public slots:
+        void reloadLayouts();
+        void setLayout(QString layout);
+
+    private slots:
+        void activeWindowChanged();
+
+    private:
+        KeyboardLayoutManagerPrivate* d;
+
+        void lockGroup(int group);
+        void groupChanged(int group);
+};
+
+#endif // KEYBOARDLAYOUTMANAGER_H
@@ -27,9 +27,12 @@
 #include "onboarding.h"
 #include "tutorialwindow.h"
 #include "audiomanager.h"
+#include "keyboardlayoutmanager.h"
 #include "dbussignals.h"
 #include "screenrecorder.h"
 #include <soundengine.h>
+#include <actiontracer.h>
+#include <mpris/mprishub.h>
 #include <iostream>
 //#include "dbusmenuregistrar.h"
 #include <nativeeventfilter.h>
@@ -58,6 +61,7 @@ NativeEventFilter* NativeFilter = NULL;
 DbusEvents* DBusEvents = NULL;
 TutorialWindow* TutorialWin = NULL;
 AudioManager* AudioMan = NULL;
+KeyboardLayoutManager* KeyboardLayoutMan = nullptr;
 LocationServices* locationServices = NULL;
 QDBusServiceWatcher* dbusServiceWatcher = NULL;
 QDBusServiceWatcher* dbusServiceWatcherSystem = NULL;
@@ -312,8 +316,11 @@ int main(int argc, char *argv[])
     locationServices = new LocationServices();
     TutorialWin = new TutorialWindow(tutorialDoSettings);
     AudioMan = new AudioManager;
+    KeyboardLayoutMan = new KeyboardLayoutManager;
     screenRecorder = new ScreenRecorder;
     HotkeyHud::makeInstance();
+    ActionTracer::instance();
+    MprisHub::instance();
 
     if (!QDBusConnection::sessionBus().interface()->registeredServiceNames().value().contains("org.kde.kdeconnect") && QFile("/usr/lib/kdeconnectd").exists()) {
         //Start KDE Connect if it is not running and it is existant on the PC
@@ -352,6 +359,7 @@ int main(int argc, char *argv[])
 
     //Play the startup sound
     SoundEngine::play(SoundEngine::Login);
+    SoundEngine::preload(SoundEngine::Notification);
 
     return a.exec();
 }
@@ -22,8 +22,8 @@
 #include "ui_mainwindow.h"
 
 #include <QScroller>
-#include <mpris/mprisengine.h>
 #include <mpris/mprisplayer.h>
+#include <mpris/mprishub.h>
 #include <globalkeyboard/globalkeyboardengine.h>
 #include "soundengine.h"
 
@@ -87,41 +87,40 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->StatusBarFrame->setFixedHeight(24 * getDPIScaling());
 
     //Set the menu of the MPRIS Media Player selection to a new menu.
-    QActionGroup* mprisGroup = new QActionGroup(this);
     QMenu* mprisSelectionMenu = new QMenu();
-    mprisSelectionMenu->addSection(tr("Media Player"));
     ui->mprisSelection->setMenu(mprisSelectionMenu);
     connect(mprisSelectionMenu, &QMenu::aboutToShow, [=]() {
         lockMovement("MPRIS");
+
+        //Build the list from the hub each time so nothing needs to be kept in sync
+        mprisSelectionMenu->clear();
+        mprisSelectionMenu->addSection(tr("Media Player"));
+        for (MprisPlayerPtr player : MprisHub::players()) {
+            QAction* action = mprisSelectionMenu->addAction(player->identity());
+            action->setCheckable(true);
+            action->setChecked(player == currentPlayer);
+            connect(action, &QAction::triggered, this, [=] {
+                MprisHub::setCurrentPlayer(player);
+            });
+        }
+
+        if (!currentPlayer.isNull()) {
+            mprisSelectionMenu->addSeparator();
+            QAction* pinAction = mprisSelectionMenu->addAction(tr("Always use %1").arg(currentPlayer->identity()));
+            pinAction->setCheckable(true);
+            pinAction->setChecked(MprisHub::isPinned(currentPlayer));
+            connect(pinAction, &QAction::toggled, this, [=](bool checked) {
+                MprisHub::setPinned(currentPlayer, checked);
+            });
+        }
     });
     connect(mprisSelectionMenu, &QMenu::aboutToHide, [=]() {
         unlockMovement("MPRIS");
     });
 
     //Prepare MPRIS
-    setMprisCurrentApp(nullptr);
-    auto addMprisPlayer = [=](QString service, MprisPlayerPtr player) {
-        Q_UNUSED(service)
-        QAction* action = mprisSelectionMenu->addAction(player->identity());
-        action->setData(QVariant::fromValue(player));
-        action->setCheckable(true);
-        connect(action, &QAction::triggered, this, [=] {
-            setMprisCurrentApp(action);
-        });
-        connect(player.data(), &MprisPlayer::identityChanged, action, [=] {
-            action->setText(player->identity());
-        });
-        connect(player.data(), &MprisPlayer::gone, action, &QAction::deleteLater);
-        mprisGroup->addAction(action);
-
-        if (currentPlayer.isNull()) {
-            setMprisCurrentApp(action);
-        }
-    };
-    for (MprisPlayerPtr player : MprisEngine::players()) {
-        addMprisPlayer(player->service(), player);
-    }
-    connect(MprisEngine::instance(), &MprisEngine::newPlayer, this, addMprisPlayer);
+    setMprisCurrentPlayer(MprisHub::currentPlayer());
+    connect(MprisHub::instance(), &MprisHub::currentPlayerChanged, this, &MainWindow::setMprisCurrentPlayer);
 
     //Connect signals related to multiple monitor management
     connect(QApplication::desktop(), SIGNAL(screenCountChanged(int)), this, SLOT(reloadScreens()));
@@ -487,12 +486,12 @@ void MainWindow::doUpdate() {
     }
 }
 
-void MainWindow::setMprisCurrentApp(QAction* app) {
+void MainWindow::setMprisCurrentPlayer(MprisPlayerPtr player) {
     //Set up the context object
     if (mprisContextObject != nullptr) mprisContextObject->deleteLater();
     mprisContextObject = new QObject(this);
 
-    if (app == nullptr) {
+    if (player.isNull()) {
         ui->mprisFrame->setVisible(false);
         ui->StatusBarMpris->setVisible(false);
         ui->StatusBarMprisIcon->setVisible(false);
@@ -501,10 +500,9 @@ void MainWindow::setMprisCurrentApp(QAction* app) {
         ui->mprisFrame->setVisible(true);
         ui->StatusBarMpris->setVisible(true);
         ui->StatusBarMprisIcon->setVisible(true);
-        app->setChecked(true);
 
         //Connect signals
-        currentPlayer = app->data().value<MprisPlayerPtr>();
+        currentPlayer = player;
         auto setMetadataFunction = [=] {
             QString statusString;
             QString title = currentPlayer->metadata().value("xesam:title").toString();
@@ -531,25 +529,16 @@ void MainWindow::setMprisCurrentApp(QAction* app) {
             ui->mprisPause->setIcon(QIcon::fromTheme("media-playback-start"));
             ui->StatusBarMprisIcon->setPixmap(QIcon::fromTheme("media-playback-pause").pixmap(SC_DPI(16), SC_DPI(16)));
         }
-        connect(currentPlayer.data(), &MprisPlayer::metadataChanged, mprisContextObject, setMetadataFunction);
-        connect(currentPlayer.data(), &MprisPlayer::playbackStatusChanged, mprisContextObject, [=] {
-            if (currentPlayer->playbackStatus() == MprisPlayer::Playing) {
-                ui->mprisPause->setIcon(QIcon::fromTheme("media-playback-pause"));
-                ui->StatusBarMprisIcon->setPixmap(QIcon::fromTheme("media-playback-start").pixmap(SC_DPI(16), SC_DPI(16)));
-            } else {
-                ui->mprisPause->setIcon(QIcon::fromTheme("media-playback-start"));
-                ui->StatusBarMprisIcon->setPixmap(QIcon::fromTheme("media-playback-pause").pixmap(SC_DPI(16), SC_DPI(16)));
-            }
-        });
-        connect(currentPlayer.data(), &MprisPlayer::gone, mprisContextObject, [=] {
-            QList<QAction*> actions = ui->mprisSelection->menu()->actions();
-            actions.removeFirst(); //Remove the section heading
-            actions.removeAll(app); //Remove the current player
-
-            if (actions.count() > 0) {
-                setMprisCurrentApp(actions.first());
-            } else {
-                setMprisCurrentApp(nullptr);
+        connect(currentPlayer.data(), &MprisPlayer::stateChanged, mprisContextObject, [=](MprisPlayer::StateProperties changed) {
+            if (changed.testFlag(MprisPlayer::MetadataProperty) || changed.testFlag(MprisPlayer::IdentityProperty)) setMetadataFunction();
+            if (changed.testFlag(MprisPlayer::PlaybackStatusProperty)) {
+                if (currentPlayer->playbackStatus() == MprisPlayer::Playing) {
+                    ui->mprisPause->setIcon(QIcon::fromTheme("media-playback-pause"));
+                    ui->StatusBarMprisIcon->setPixmap(QIcon::fromTheme("media-playback-start").pixmap(SC_DPI(16), SC_DPI(16)));
+                } else {
+                    ui->mprisPause->setIcon(QIcon::fromTheme("media-playback-start"));
+                    ui->StatusBarMprisIcon->setPixmap(QIcon::fromTheme("media-playback-pause").pixmap(SC_DPI(16), SC_DPI(16)));
+                }
             }
         });
     }
@@ -790,6 +779,7 @@ void MainWindow::on_timer_clicked()
 
 void MainWindow::on_mprisPause_clicked()
 {
+    if (currentPlayer.isNull()) return;
     currentPlayer->playPause();
 }
 
@@ -893,16 +883,19 @@ void MainWindow::calculateAndMoveBar()
 
 void MainWindow::on_mprisBack_clicked()
 {
+    if (currentPlayer.isNull()) return;
     currentPlayer->previous();
 }
 
 void MainWindow::on_mprisForward_clicked()
 {
+    if (currentPlayer.isNull()) return;
     currentPlayer->next();
 }
 
 void MainWindow::on_mprisSongName_clicked()
 {
+    if (currentPlayer.isNull()) return;
     currentPlayer->raise();
 }
 
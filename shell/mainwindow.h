@@ -148,7 +148,7 @@ private slots:
 
     void on_timer_clicked();
 
-    void setMprisCurrentApp(QAction* action);
+    void setMprisCurrentPlayer(MprisPlayerPtr player);
 
     void reloadScreens();
 
@@ -25,6 +25,7 @@
 #include <application.h>
 #include <notificationsdbusadaptor.h>
 #include <Wm/desktopwm.h>
+#include <actiontracer.h>
 
 extern void EndSession(EndSessionWait::shutdownType type);
 extern float getDPIScaling();
@@ -480,6 +481,7 @@ void Menu::paintEvent(QPaintEvent *event) {
     }
 
     event->accept();
+    ActionTracer::markPainted();
 }
 
 
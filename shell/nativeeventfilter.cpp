@@ -49,6 +49,15 @@
 #include "menu.h"
 
 #include "soundengine.h"
+#include "keyboardlayoutmanager.h"
+#include "gestures/gesturerecognizer.h"
+#include "infopanedropdown.h"
+#include <Wm/desktopwm.h>
+#include <actiontracer.h>
+#include <gestureactions.h>
+
+#include <QScreen>
+#include <climits>
 
 #include <X11/XF86keysym.h>
 #include <X11/keysym.h>
@@ -58,45 +67,16 @@
 #define Status int
 #include <X11/extensions/XInput2.h>
 #include <X11/extensions/XI2proto.h>
+#include "xi2wire.h"
 
 extern void EndSession(EndSessionWait::shutdownType type);
 extern DbusEvents* DBusEvents;
 extern MainWindow* MainWin;
 extern AudioManager* AudioMan;
+extern KeyboardLayoutManager* KeyboardLayoutMan;
 extern ScreenRecorder* screenRecorder;
 
 
-class GeEventMemMover
-{
-public:
-    GeEventMemMover(xcb_generic_event_t *event)
-        : m_event(reinterpret_cast<xcb_ge_generic_event_t *>(event))
-    {
-        // xcb event structs contain stuff that wasn't on the wire, the full_sequence field
-        // adds an extra 4 bytes and generic events cookie data is on the wire right after the standard 32 bytes.
-        // Move this data back to have the same layout in memory as it was on the wire
-        // and allow casting, overwriting the full_sequence field.
-        memmove((char*) m_event + 32, (char*) m_event + 36, m_event->length * 4);
-    }
-    ~GeEventMemMover()
-    {
-        // move memory layout back, so that Qt can do the same without breaking
-        memmove((char*) m_event + 36, (char *) m_event + 32, m_event->length * 4);
-    }
-
-    xcb_ge_generic_event_t *operator->() const {
-        return m_event;
-    }
-
-private:
-    xcb_ge_generic_event_t *m_event;
-};
-
-static inline qreal fixed1616ToReal(FP1616 val)
-{
-    return (val) * 1.0 / (1 << 16);
-}
-
 struct NativeEventFilterPrivate {
     enum TouchTrackingType {
         None,
@@ -118,9 +98,202 @@ struct NativeEventFilterPrivate {
     TouchTrackingType touchTrackingType;
 
     QHash<uint32_t, QPointF> firstTouchPoints;
-    QVector<QPointF> touchPoints;
+
+    //The last few points of the tracked touch, kept in a ring so updates don't allocate
+    static const int TouchHistoryLength = 10;
+    QPointF touchHistory[TouchHistoryLength];
+    int touchHistoryCount = 0;
+    int touchHistoryIndex = 0;
+
+    //XI2 event types we asked for; everything else is left for Qt without looking any further
+    quint64 xiEvents = 0;
+    KeyCode numLockKeycode, capsLockKeycode;
+
+    GestureRecognizer* gestures;
+    quint32 lastTouchTime = 0;
+    QHash<int, QRectF> touchDeviceRanges;
+    QHash<int, QRectF> touchDeviceScreens;
+
+    QRectF touchDeviceRange(int deviceId);
+    QRectF touchDeviceScreen(int deviceId);
+    bool edgeHasGestureAction(QPointF point, QRectF screenGeometry);
+
+    //Called by xiHandleTouchEvent
+    void touchBegin(const xXIDeviceEvent& event);
+    bool wantsTouchUpdates();
+    void touchUpdate(const xXIDeviceEvent& event);
+    void touchEnd(const xXIDeviceEvent& event);
+    bool touchOwnership(const xXITouchOwnershipEvent& event);
+    void rawTouch(const xXIRawEvent& event);
+    void rawTouchEnd(const xXIRawEvent& event);
+    bool isTrackingRawTouch(const xXIRawEvent& event);
+    void rawTouchPoint(int type, const xXIRawEvent& event, qreal axes[2]);
 };
 
+QRectF NativeEventFilterPrivate::touchDeviceRange(int deviceId) {
+    if (touchDeviceRanges.contains(deviceId)) return touchDeviceRanges.value(deviceId);
+
+    //Raw events are in device coordinates, so find out what the device reports
+    QRectF range;
+    int count;
+    XIDeviceInfo* info = XIQueryDevice(QX11Info::display(), deviceId, &count);
+    if (info != nullptr) {
+        for (int i = 0; i < info->num_classes; i++) {
+            if (info->classes[i]->type != XIValuatorClass) continue;
+            XIValuatorClassInfo* valuator = reinterpret_cast<XIValuatorClassInfo*>(info->classes[i]);
+            if (valuator->number == 0) {
+                range.setLeft(valuator->min);
+                range.setRight(valuator->max);
+            } else if (valuator->number == 1) {
+                range.setTop(valuator->min);
+                range.setBottom(valuator->max);
+            }
+        }
+        XIFreeDeviceInfo(info);
+    }
+
+    touchDeviceRanges.insert(deviceId, range);
+    return range;
+}
+
+QRectF NativeEventFilterPrivate::touchDeviceScreen(int deviceId) {
+    if (touchDeviceScreens.contains(deviceId)) return touchDeviceScreens.value(deviceId);
+
+    //Touch screens cover the whole root window unless they've been mapped to an output
+    QRectF root = QApplication::primaryScreen()->virtualGeometry();
+    QRectF screen = root;
+
+    //Mapping a device to an output sets its transformation matrix, which scales and moves
+    //normalised device coordinates into the part of the root window that output covers
+    Atom matrixAtom = XInternAtom(QX11Info::display(), "Coordinate Transformation Matrix", True);
+    if (matrixAtom != None) {
+        Atom type;
+        int format;
+        unsigned long items, bytesAfter;
+        unsigned char* data = nullptr;
+        if (XIGetProperty(QX11Info::display(), deviceId, matrixAtom, 0, 9, False, AnyPropertyType, &type, &format, &items, &bytesAfter, &data) == Success) {
+            if (format == 32 && items == 9) {
+                float* matrix = reinterpret_cast<float*>(data);
+
+                //Rotated outputs aren't a rectangle we can use, so leave those covering the root window
+                if (matrix[1] == 0 && matrix[3] == 0 && matrix[0] > 0 && matrix[4] > 0) {
+                    screen = QRectF(root.x() + matrix[2] * root.width(), root.y() + matrix[5] * root.height(),
+                                    matrix[0] * root.width(), matrix[4] * root.height());
+                }
+            }
+            XFree(data);
+        }
+    }
+
+    touchDeviceScreens.insert(deviceId, screen);
+    return screen;
+}
+
+bool NativeEventFilterPrivate::edgeHasGestureAction(QPointF point, QRectF screenGeometry) {
+    GestureRecognizer::Gesture edge;
+    edge.type = GestureRecognizer::EdgeSwipe;
+    edge.direction = gestures->edgeDirection(point, screenGeometry);
+    if (edge.direction == GestureRecognizer::NoDirection) return false;
+
+    return NativeEventFilter::gestureAction(edge.name()) != "none";
+}
+
+void NativeEventFilterPrivate::touchBegin(const xXIDeviceEvent& event) {
+    firstTouchPoints.insert(event.detail, QPointF(fixed1616ToReal(event.event_x), fixed1616ToReal(event.event_y)));
+}
+
+bool NativeEventFilterPrivate::wantsTouchUpdates() {
+    return touchTracking != 0;
+}
+
+void NativeEventFilterPrivate::touchUpdate(const xXIDeviceEvent& event) {
+    if (touchTracking != event.detail) return;
+
+    switch (touchTrackingType) {
+        case GatewayOpen:
+            MainWin->getMenu()->showPartial(fixed1616ToReal(event.event_x));
+            break;
+    }
+
+    touchHistory[touchHistoryIndex] = QPointF(fixed1616ToReal(event.event_x), fixed1616ToReal(event.event_y));
+    touchHistoryIndex = (touchHistoryIndex + 1) % TouchHistoryLength;
+    if (touchHistoryCount < TouchHistoryLength) touchHistoryCount++;
+}
+
+void NativeEventFilterPrivate::touchEnd(const xXIDeviceEvent& event) {
+    if (touchTracking == event.detail) {
+        switch (touchTrackingType) {
+            case GatewayOpen: {
+                //Compare against the oldest point we still remember
+                int oldest = touchHistoryCount < TouchHistoryLength ? 0 : touchHistoryIndex;
+                if (touchHistoryCount != 0 && touchHistory[oldest].x() < fixed1616ToReal(event.event_x)) {
+                    MainWin->getMenu()->show();
+                } else {
+                    MainWin->getMenu()->close();
+                }
+            }
+        }
+
+        touchTracking = 0;
+        touchTrackingType = None;
+    }
+    firstTouchPoints.remove(event.detail);
+}
+
+bool NativeEventFilterPrivate::touchOwnership(const xXITouchOwnershipEvent& event) {
+    touchHistoryCount = 0;
+    touchHistoryIndex = 0;
+
+    if (firstTouchPoints.contains(event.touchid)) {
+        QRect screenGeometry = QApplication::screens().first()->geometry();
+        QPointF point = firstTouchPoints.value(event.touchid);
+        if (point.x() >= screenGeometry.x() && point.x() < screenGeometry.x() + 20 && !MainWin->getMenu()->isVisible() && settings.value("gestures/swipeGateway", true).toBool()) {
+            //Open the Gateway
+            touchTracking = event.touchid;
+            touchTrackingType = GatewayOpen;
+            XIAllowTouchEvents(QX11Info::display(), event.deviceid, event.touchid, QX11Info::appRootWindow(), XIAcceptTouch);
+            MainWin->getMenu()->prepareForShow();
+            return true;
+        } else if (edgeHasGestureAction(point, touchDeviceScreen(event.sourceid))) {
+            //Keep edge swipes away from whatever is underneath
+            XIAllowTouchEvents(QX11Info::display(), event.deviceid, event.touchid, QX11Info::appRootWindow(), XIAcceptTouch);
+            return true;
+        }
+    }
+
+    //We don't know what to do with this, so reject it immediately
+    XIAllowTouchEvents(QX11Info::display(), event.deviceid, event.touchid, QX11Info::appRootWindow(), XIRejectTouch);
+    return false;
+}
+
+void NativeEventFilterPrivate::rawTouch(const xXIRawEvent& event) {
+    lastTouchTime = event.time;
+}
+
+void NativeEventFilterPrivate::rawTouchEnd(const xXIRawEvent& event) {
+    gestures->touchEnd(event.detail);
+}
+
+bool NativeEventFilterPrivate::isTrackingRawTouch(const xXIRawEvent& event) {
+    return gestures->isTracking(event.detail);
+}
+
+void NativeEventFilterPrivate::rawTouchPoint(int type, const xXIRawEvent& event, qreal axes[2]) {
+    QRectF range = touchDeviceRange(event.sourceid);
+    if (range.width() <= 0 || range.height() <= 0) return;
+
+    QRectF screenGeometry = touchDeviceScreen(event.sourceid);
+    QPointF point(screenGeometry.x() + (axes[0] - range.left()) / range.width() * screenGeometry.width(),
+                  screenGeometry.y() + (axes[1] - range.top()) / range.height() * screenGeometry.height());
+    if (type == XI_RawTouchBegin) {
+        //Edges belong to the output this touch screen drives
+        gestures->setScreenGeometry(screenGeometry);
+        gestures->touchBegin(event.detail, point);
+    } else {
+        gestures->touchUpdate(event.detail, point);
+    }
+}
+
 NativeEventFilter::NativeEventFilter(QObject* parent) : QObject(parent)
 {
     d = new NativeEventFilterPrivate();
@@ -131,8 +304,10 @@ NativeEventFilter::NativeEventFilter(QObject* parent) : QObject(parent)
     connect(d->powerButtonTimer, SIGNAL(timeout()), this, SLOT(handlePowerButton()));
 
     //Capture required keys
-    XGrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Num_Lock), AnyModifier, RootWindow(QX11Info::display(), 0), true, GrabModeAsync, GrabModeAsync);
-    XGrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Caps_Lock), AnyModifier, RootWindow(QX11Info::display(), 0), true, GrabModeAsync, GrabModeAsync);
+    d->numLockKeycode = XKeysymToKeycode(QX11Info::display(), XK_Num_Lock);
+    d->capsLockKeycode = XKeysymToKeycode(QX11Info::display(), XK_Caps_Lock);
+    XGrabKey(QX11Info::display(), d->numLockKeycode, AnyModifier, RootWindow(QX11Info::display(), 0), true, GrabModeAsync, GrabModeAsync);
+    XGrabKey(QX11Info::display(), d->capsLockKeycode, AnyModifier, RootWindow(QX11Info::display(), 0), true, GrabModeAsync, GrabModeAsync);
 
     //Check if the user wants to capture the super key
     if (d->settings.value("input/superkeyGateway", true).toBool()) {
@@ -157,12 +332,21 @@ NativeEventFilter::NativeEventFilter(QObject* parent) : QObject(parent)
         initXinput = false;
     }
 
+    d->gestures = new GestureRecognizer(this);
+    connect(QApplication::primaryScreen(), &QScreen::virtualGeometryChanged, this, [=] {
+        //Outputs moved around, so work out where each touch screen is again
+        d->touchDeviceScreens.clear();
+    });
+    connect(d->gestures, &GestureRecognizer::gestureFinished, this, &NativeEventFilter::handleGesture);
+
     if (initXinput) {
         //Capture the touch screen
-        XIEventMask masks[1];
+        XIEventMask masks[2];
         unsigned char mask1[XIMaskLen(XI_LASTEVENT)];
+        unsigned char mask2[XIMaskLen(XI_LASTEVENT)];
 
         memset(mask1, 0, sizeof(mask1));
+        memset(mask2, 0, sizeof(mask2));
 
         XISetMask(mask1, XI_TouchBegin);
         XISetMask(mask1, XI_TouchUpdate);
@@ -173,19 +357,31 @@ NativeEventFilter::NativeEventFilter(QObject* parent) : QObject(parent)
         masks[0].mask_len = sizeof(mask1);
         masks[0].mask = mask1;
 
+        //Raw touch events reach us whoever owns the touch, so gestures can be
+        //recognized without taking the touches away from applications
+        XISetMask(mask2, XI_RawTouchBegin);
+        XISetMask(mask2, XI_RawTouchUpdate);
+        XISetMask(mask2, XI_RawTouchEnd);
+
+        masks[1].deviceid = XIAllMasterDevices;
+        masks[1].mask_len = sizeof(mask2);
+        masks[1].mask = mask2;
+
+        d->xiEvents = xiTouchEvents();
+
         XSetErrorHandler([](Display* d, XErrorEvent* e) {
             qDebug() << "X11 error:" << e->error_code;
             return 0;
         });
-        XISelectEvents(QX11Info::display(), QX11Info::appRootWindow(), masks, 1);
+        XISelectEvents(QX11Info::display(), QX11Info::appRootWindow(), masks, 2);
     }
 }
 
 NativeEventFilter::~NativeEventFilter() {
     XUngrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Super_L), AnyModifier, QX11Info::appRootWindow());
     XUngrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Super_R), AnyModifier, QX11Info::appRootWindow());
-    XUngrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Num_Lock), AnyModifier, QX11Info::appRootWindow());
-    XUngrabKey(QX11Info::display(), XKeysymToKeycode(QX11Info::display(), XK_Caps_Lock), AnyModifier, QX11Info::appRootWindow());
+    XUngrabKey(QX11Info::display(), d->numLockKeycode, AnyModifier, QX11Info::appRootWindow());
+    XUngrabKey(QX11Info::display(), d->capsLockKeycode, AnyModifier, QX11Info::appRootWindow());
 
     delete d;
 }
@@ -196,7 +392,10 @@ bool NativeEventFilter::nativeEventFilter(const QByteArray &eventType, void *mes
 
     if (eventType == "xcb_generic_event_t") {
         xcb_generic_event_t* event = static_cast<xcb_generic_event_t*>(message);
-        if (event->response_type == XCB_CLIENT_MESSAGE || event->response_type == (XCB_CLIENT_MESSAGE | 128)) { //System Tray Event
+        if (KeyboardLayoutMan->xkbEvent(event)) {
+            //Qt needs to see XKB state changes as well
+            return false;
+        } else if (event->response_type == XCB_CLIENT_MESSAGE || event->response_type == (XCB_CLIENT_MESSAGE | 128)) { //System Tray Event
             //Get the message
             xcb_client_message_event_t* client = static_cast<xcb_client_message_event_t*>(message);
 
@@ -205,74 +404,10 @@ bool NativeEventFilter::nativeEventFilter(const QByteArray &eventType, void *mes
                 emit SysTrayEvent(client->data.data32[1], client->data.data32[2], client->data.data32[3], client->data.data32[4]);
             }
         } else if (event->response_type == XCB_GE_GENERIC) {
-            GeEventMemMover ge(event);
-            if (ge->extension == d->xiOpcode) {
-                switch (ge->event_type) {
-                    case XI_TouchBegin: {
-                        xXIDeviceEvent* dEvent = reinterpret_cast<xXIDeviceEvent*>(event);
-
-                        d->firstTouchPoints.insert(dEvent->detail, QPointF(fixed1616ToReal(dEvent->event_x), fixed1616ToReal(dEvent->event_y)));
-                        break;
-                    }
-                    case XI_TouchUpdate: {
-                        xXIDeviceEvent* dEvent = reinterpret_cast<xXIDeviceEvent*>(event);
-                        if (d->touchTracking == dEvent->detail) {
-                            switch (d->touchTrackingType) {
-                                case NativeEventFilterPrivate::GatewayOpen:
-                                    MainWin->getMenu()->showPartial(fixed1616ToReal(dEvent->event_x));
-                                    break;
-                            }
-
-                            d->touchPoints.prepend(QPointF(fixed1616ToReal(dEvent->event_x), fixed1616ToReal(dEvent->event_y)));
-                            if (d->touchPoints.count() > 10) d->touchPoints.removeLast();
-                        }
-                        break;
-                    }
-                    case XI_TouchEnd: {
-                        xXIDeviceEvent* dEvent = reinterpret_cast<xXIDeviceEvent*>(event);
-
-                        if (d->touchTracking == dEvent->detail) {
-                            switch (d->touchTrackingType) {
-                                case NativeEventFilterPrivate::GatewayOpen:
-                                    if (!d->touchPoints.isEmpty() && d->touchPoints.last().x() < fixed1616ToReal(dEvent->event_x)) {
-                                        MainWin->getMenu()->show();
-                                    } else {
-                                        MainWin->getMenu()->close();
-                                    }
-                            }
-
-                            d->touchTracking = 0;
-                            d->touchTrackingType = NativeEventFilterPrivate::None;
-                        }
-                        d->firstTouchPoints.remove(dEvent->detail);
-                        break;
-                    }
-                    case XI_TouchOwnership: {
-                        d->touchPoints.clear();
-
-                        xXITouchOwnershipEvent* dEvent = reinterpret_cast<xXITouchOwnershipEvent*>(event);
-                        if (d->firstTouchPoints.contains(dEvent->touchid)) {
-                            QRect screenGeometry = QApplication::screens().first()->geometry();
-                            QPointF point = d->firstTouchPoints.value(dEvent->touchid);
-                            if (point.x() >= screenGeometry.x() && point.x() < screenGeometry.x() + 20 && !MainWin->getMenu()->isVisible() && d->settings.value("gestures/swipeGateway", true).toBool()) {
-                                //Open the Gateway
-                                d->touchTracking = dEvent->touchid;
-                                d->touchTrackingType = NativeEventFilterPrivate::GatewayOpen;
-                                XIAllowTouchEvents(QX11Info::display(), dEvent->deviceid, dEvent->touchid, QX11Info::appRootWindow(), XIAcceptTouch);
-                                MainWin->getMenu()->prepareForShow();
-                                return true;
-                            }
-                        }
-
-                        //We don't know what to do with this, so reject it immediately
-                        XIAllowTouchEvents(QX11Info::display(), dEvent->deviceid, dEvent->touchid, QX11Info::appRootWindow(), XIRejectTouch);
-                        break;
-                    }
-                }
-            }
+            return xiHandleTouchEvent(event, d->xiOpcode, d->xiEvents, *d);
         } else if (event->response_type == XCB_KEY_RELEASE) {
             xcb_key_release_event_t* button = static_cast<xcb_key_release_event_t*>(message);
-            if (button->detail == XKeysymToKeycode(QX11Info::display(), XK_Num_Lock) || button->detail == XKeysymToKeycode(QX11Info::display(), XK_Caps_Lock)) {
+            if (button->detail == d->numLockKeycode || button->detail == d->capsLockKeycode) {
                 if (d->themeSettings->value("accessibility/bellOnCapsNumLock", false).toBool()) {
                     QSoundEffect* sound = new QSoundEffect();
                     sound->setSource(QUrl("qrc:/sounds/keylocks.wav"));
@@ -285,6 +420,36 @@ bool NativeEventFilter::nativeEventFilter(const QByteArray &eventType, void *mes
     return false;
 }
 
+QString NativeEventFilter::gestureAction(QString gesture) {
+    QSettings settings;
+    return GestureActions::action(settings, gesture);
+}
+
+void NativeEventFilter::handleGesture(GestureRecognizer::Gesture gesture) {
+    if (gesture.progress < 1) return; //Not far enough to count
+
+    QString action = gestureAction(gesture.name());
+    if (action == "none") return;
+
+    if (ActionTracer::isTracing()) ActionTracer::beginTrace(gesture.name(), d->lastTouchTime);
+    if (action == "gateway") {
+        MainWin->openMenu();
+    } else if (action == "statuscenter") {
+        MainWin->getInfoPane()->show(InfoPaneDropdown::Clock);
+    } else if (action == "next-desktop") {
+        uint switchToDesktop = DesktopWm::currentDesktop() + 1;
+        if (switchToDesktop == static_cast<uint>(DesktopWm::desktops().count())) switchToDesktop = 0;
+        DesktopWm::setCurrentDesktop(switchToDesktop);
+    } else if (action == "previous-desktop") {
+        uint switchToDesktop = DesktopWm::currentDesktop() - 1;
+        if (switchToDesktop == UINT_MAX) switchToDesktop = static_cast<uint>(DesktopWm::desktops().count()) - 1;
+        DesktopWm::setCurrentDesktop(switchToDesktop);
+    } else if (action == "show-desktop") {
+        DesktopWm::setShowDesktop(true);
+    }
+    ActionTracer::markHandled();
+}
+
 void NativeEventFilter::handlePowerButton() {
     if (!d->isEndSessionBoxShowing && !d->powerPressed) {
         //Perform an action depending on what the user wants
@@ -43,6 +43,7 @@
 #include <QMessageBox>
 #include <QSoundEffect>
 #include "screenshotwindow.h"
+#include "gestures/gesturerecognizer.h"
 
 struct NativeEventFilterPrivate;
 class NativeEventFilter : public QObject, public QAbstractNativeEventFilter
@@ -52,11 +53,14 @@ class NativeEventFilter : public QObject, public QAbstractNativeEventFilter
         explicit NativeEventFilter(QObject* parent = 0);
         ~NativeEventFilter();
 
+        static QString gestureAction(QString gesture);
+
     signals:
         void SysTrayEvent(long opcode, long data2, long data3, long data4);
 
     public slots:
         void handlePowerButton();
+        void handleGesture(GestureRecognizer::Gesture gesture);
 
     private:
         bool nativeEventFilter(const QByteArray &eventType, void *message, long *result);
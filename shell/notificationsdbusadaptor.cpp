@@ -21,6 +21,8 @@
 
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 
 NotificationsDBusAdaptor* NotificationsDBusAdaptor::i = nullptr;
 
@@ -48,10 +50,21 @@ tPromise<uint>* NotificationsDBusAdaptor::Notify(const QString &app_name, uint r
 }
 
 tPromise<uint>* NotificationsDBusAdaptor::DoNotify(const QString &app_name, uint replaces_id, const QString &app_icon, const QString &summary, const QString &body, const QStringList &actions, const QVariantMap &hints, int expire_timeout) {
-    return new tPromise<uint>([=](QString& error) {
+    return new tPromise<uint>([=](std::function<void(uint)> res, std::function<void(QString)> rej) {
         QDBusMessage msg = QDBusMessage::createMethodCall("org.freedesktop.Notifications", "/org/freedesktop/Notifications", "org.freedesktop.Notifications", "Notify");
         msg.setArguments({app_name, replaces_id, app_icon, summary, body, actions, hints, expire_timeout});
-        return QDBusConnection::sessionBus().call(msg).arguments().first().toUInt();
+
+        //Don't hold up the caller if the notification server is busy
+        QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg));
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+            QDBusPendingReply<uint> reply = *watcher;
+            if (reply.isError()) {
+                rej(reply.error().message());
+            } else {
+                res(reply.value());
+            }
+            watcher->deleteLater();
+        });
     });
 }
 
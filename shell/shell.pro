@@ -13,7 +13,7 @@ DEPENDPATH += $$PWD/../theshell-lib
 
 unix {
     CONFIG += link_pkgconfig
-    PKGCONFIG += glib-2.0 x11 x11-xcb xcb-keysyms xscrnsaver xext libpulse libpulse-mainloop-glib libsystemd libunwind polkit-qt5-1 xi
+    PKGCONFIG += glib-2.0 x11 x11-xcb xcb-keysyms xscrnsaver xext xcb-xkb libpulse libpulse-mainloop-glib alsa libsystemd libunwind polkit-qt5-1 xi
 }
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -93,7 +93,9 @@ SOURCES += main.cpp\
     location/locationrequestdialog.cpp \
     agent_adaptor.cpp \
     locktypes/mousepassword.cpp \
-    notificationsdbusadaptor.cpp
+    notificationsdbusadaptor.cpp \
+    keyboardlayoutmanager.cpp \
+    gestures/gesturerecognizer.cpp
 
 HEADERS  += mainwindow.h \
     taskbarbutton.h \
@@ -131,7 +133,10 @@ HEADERS  += mainwindow.h \
     locktypes/mousepassword.h \
     statuscenter/statuscenterpane.h \
     statuscenter/statuscenterpaneobject.h \
-    notificationsdbusadaptor.h
+    notificationsdbusadaptor.h \
+    keyboardlayoutmanager.h \
+    gestures/gesturerecognizer.h \
+    xi2wire.h
 
 FORMS    += mainwindow.ui \
     menu.ui \
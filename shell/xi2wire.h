@@ -0,0 +1,163 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef XI2WIRE_H
+#define XI2WIRE_H
+
+#include <QtGlobal>
+#include <cstring>
+#include <initializer_list>
+#include <xcb/xcb.h>
+#include <X11/extensions/XI2.h>
+#include <X11/extensions/XI2proto.h>
+
+//Helpers for reading XI2 events straight out of the buffers xcb hands us.
+//These are shared with tools/xi2bench so that the benchmark measures exactly what the shell does.
+
+// xcb event structs contain stuff that wasn't on the wire: the full_sequence field adds an extra 4 bytes
+// and generic events carry the rest of their data on the wire right after the standard 32 bytes.
+// Instead of moving the whole event back and forth, copy the fixed part of the wire struct onto the stack.
+template <typename T> static inline void xiWireEvent(xcb_generic_event_t* event, T* wire)
+{
+    static_assert(sizeof(T) >= 32, "XI2 events are at least 32 bytes long");
+    memcpy(wire, event, 32);
+    memcpy(reinterpret_cast<char*>(wire) + 32, reinterpret_cast<char*>(event) + 36, sizeof(T) - 32);
+}
+
+// Variable length data that follows the fixed part of an XI2 event, read in place
+template <typename T> static inline char* xiWireData(xcb_generic_event_t* event)
+{
+    return reinterpret_cast<char*>(event) + 4 + sizeof(T);
+}
+
+static inline qreal fixed1616ToReal(FP1616 val)
+{
+    return (val) * 1.0 / (1 << 16);
+}
+
+static inline qreal fixed3232ToReal(FP3232 val)
+{
+    return val.integral + val.frac * 1.0 / (1ULL << 32);
+}
+
+//Whether this is an XI2 event of one of the types set in the selected mask
+static inline bool xiSelected(xcb_ge_generic_event_t* ge, int xiOpcode, quint64 selected)
+{
+    return ge->extension == xiOpcode && ge->event_type < 64 && (selected & (1ULL << ge->event_type));
+}
+
+//Reads the first two valuators of a raw event, which are X and Y on touch screens
+static inline bool xiRawAxes(xcb_generic_event_t* event, const xXIRawEvent& rEvent, qreal axes[2])
+{
+    //Valuator values follow the mask, one for each bit set in it
+    unsigned char* mask = reinterpret_cast<unsigned char*>(xiWireData<xXIRawEvent>(event));
+    FP3232* values = reinterpret_cast<FP3232*>(mask + rEvent.valuators_len * 4);
+    int found = 0;
+    for (int axis = 0; axis < 2 && axis < rEvent.valuators_len * 32; axis++) {
+        if (!XIMaskIsSet(mask, axis)) continue;
+        axes[axis] = fixed3232ToReal(*values);
+        values++;
+        found++;
+    }
+    return found == 2;
+}
+
+//The XI2 touch events the shell selects
+static inline quint64 xiTouchEvents()
+{
+    quint64 events = 0;
+    for (int type : {XI_TouchBegin, XI_TouchUpdate, XI_TouchEnd, XI_TouchOwnership, XI_RawTouchBegin, XI_RawTouchUpdate, XI_RawTouchEnd}) {
+        events |= 1ULL << type;
+    }
+    return events;
+}
+
+//Decides what to do with a generic event and decodes only as much of it as that needs.
+//The handler is told about the touch events that get through:
+//
+//  void touchBegin(const xXIDeviceEvent&)
+//  bool wantsTouchUpdates()                                   whether touch updates are worth decoding at all
+//  void touchUpdate(const xXIDeviceEvent&)
+//  void touchEnd(const xXIDeviceEvent&)
+//  bool touchOwnership(const xXITouchOwnershipEvent&)        returns whether the event was consumed
+//  void rawTouch(const xXIRawEvent&)                          every raw touch event, before anything else
+//  void rawTouchEnd(const xXIRawEvent&)
+//  bool isTrackingRawTouch(const xXIRawEvent&)               whether updates to this touch are worth decoding
+//  void rawTouchPoint(int type, const xXIRawEvent&, qreal axes[2])
+//
+//Returns whether the event was consumed.
+template <typename Handler> static inline bool xiHandleTouchEvent(xcb_generic_event_t* event, int xiOpcode, quint64 selected, Handler& handler)
+{
+    xcb_ge_generic_event_t* ge = reinterpret_cast<xcb_ge_generic_event_t*>(event);
+
+    //Motion and other high rate events that Qt selected for its own windows come through here too,
+    //so get rid of anything we didn't ask for before doing any work
+    if (!xiSelected(ge, xiOpcode, selected)) return false;
+
+    switch (ge->event_type) {
+        case XI_TouchBegin: {
+            xXIDeviceEvent dEvent;
+            xiWireEvent(event, &dEvent);
+            handler.touchBegin(dEvent);
+            break;
+        }
+        case XI_TouchUpdate: {
+            if (!handler.wantsTouchUpdates()) break;
+
+            xXIDeviceEvent dEvent;
+            xiWireEvent(event, &dEvent);
+            handler.touchUpdate(dEvent);
+            break;
+        }
+        case XI_TouchEnd: {
+            xXIDeviceEvent dEvent;
+            xiWireEvent(event, &dEvent);
+            handler.touchEnd(dEvent);
+            break;
+        }
+        case XI_RawTouchBegin:
+        case XI_RawTouchUpdate:
+        case XI_RawTouchEnd: {
+            xXIRawEvent rEvent;
+            xiWireEvent(event, &rEvent);
+            handler.rawTouch(rEvent);
+            if (ge->event_type == XI_RawTouchEnd) {
+                handler.rawTouchEnd(rEvent);
+                break;
+            } else if (ge->event_type == XI_RawTouchUpdate && !handler.isTrackingRawTouch(rEvent)) {
+                //Nothing is going to come of this touch, so don't bother decoding it
+                break;
+            }
+
+            qreal axes[2];
+            if (!xiRawAxes(event, rEvent, axes)) break;
+            handler.rawTouchPoint(ge->event_type, rEvent, axes);
+            break;
+        }
+        case XI_TouchOwnership: {
+            xXITouchOwnershipEvent dEvent;
+            xiWireEvent(event, &dEvent);
+            return handler.touchOwnership(dEvent);
+        }
+    }
+    return false;
+}
+
+#endif // XI2WIRE_H
@@ -25,6 +25,8 @@
 #include <QPainter>
 #include <QDebug>
 #include <QTimer>
+#include <QComboBox>
+#include <gestureactions.h>
 
 struct GesturePanePrivate {
     QSettings settings;
@@ -49,6 +51,38 @@ GesturePane::GesturePane(QWidget *parent) :
     ui->swipeGatewayAnimation->setFixedSize(d->swipeOpenRenderer->viewBox().size() * 2 * theLibsGlobal::getDPIScaling());
     ui->touchModeAnimation->installEventFilter(this);
     ui->touchModeAnimation->setFixedSize(d->touchModeRenderer->viewBox().size() * 2 * theLibsGlobal::getDPIScaling());
+
+    QList<QPair<QString, QString>> gestures = {
+        {"edge-top", tr("Swipe in from the top edge")},
+        {"edge-right", tr("Swipe in from the right edge")},
+        {"edge-bottom", tr("Swipe in from the bottom edge")},
+        {"swipe-left", tr("Swipe left with three fingers")},
+        {"swipe-right", tr("Swipe right with three fingers")},
+        {"swipe-up", tr("Swipe up with three fingers")},
+        {"swipe-down", tr("Swipe down with three fingers")},
+        {"pinch-in", tr("Pinch in with three fingers")},
+        {"pinch-out", tr("Spread out with three fingers")}
+    };
+    QList<QPair<QString, QString>> actions = {
+        {"none", tr("Do nothing")},
+        {"gateway", tr("Open the Gateway")},
+        {"statuscenter", tr("Open the Status Center")},
+        {"next-desktop", tr("Switch to the next desktop")},
+        {"previous-desktop", tr("Switch to the previous desktop")},
+        {"show-desktop", tr("Show the desktop")}
+    };
+
+    for (QPair<QString, QString> gesture : gestures) {
+        QComboBox* box = new QComboBox(this);
+        for (QPair<QString, QString> action : actions) {
+            box->addItem(action.second, action.first);
+        }
+        box->setCurrentIndex(box->findData(GestureActions::action(d->settings, gesture.first)));
+        connect(box, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=] {
+            d->settings.setValue("gestures/action/" + gesture.first, box->currentData().toString());
+        });
+        ui->gestureActionsLayout->addRow(gesture.second, box);
+    }
 }
 
 GesturePane::~GesturePane()
@@ -113,6 +113,7 @@ KeyboardPane::KeyboardPane(QWidget *parent) :
 
     //Load settings
     ui->SuperKeyOpenGatewaySwitch->setChecked(d->settings.value("input/superkeyGateway", true).toBool());
+    ui->PerWindowLayoutSwitch->setChecked(d->settings.value("input/perWindowLayout", true).toBool());
 
     ui->mainStack->setCurrentAnimation(tStackedWidget::SlideHorizontal);
     QScroller::grabGesture(ui->availableKeyboardLayouts, QScroller::LeftMouseButtonGesture);
@@ -192,6 +193,11 @@ void KeyboardPane::on_SuperKeyOpenGatewaySwitch_toggled(bool checked)
     d->settings.setValue("input/superkeyGateway", checked);
 }
 
+void KeyboardPane::on_PerWindowLayoutSwitch_toggled(bool checked)
+{
+    d->settings.setValue("input/perWindowLayout", checked);
+}
+
 void KeyboardPane::changeEvent(QEvent *event) {
     if (event->type() == QEvent::LanguageChange) {
         ui->retranslateUi(this);
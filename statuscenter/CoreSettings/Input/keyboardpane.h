@@ -52,6 +52,8 @@ class KeyboardPane : public QWidget
 
         void on_SuperKeyOpenGatewaySwitch_toggled(bool checked);
 
+        void on_PerWindowLayoutSwitch_toggled(bool checked);
+
     private:
         Ui::KeyboardPane *ui;
 
@@ -77,6 +77,10 @@ ShortcutPane::ShortcutPane(QWidget *parent) :
         addShortcut({tr("Volume Up"), tr("Increase the volume"), "VolumeUp", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::VolumeUp), {QKeySequence(Qt::Key_VolumeUp)}});
         addShortcut({tr("Volume Down"), tr("Decrease the volume"), "VolumeDown", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::VolumeDown), {QKeySequence(Qt::Key_VolumeDown)}});
         addShortcut({tr("Toggle Quiet Mode"), tr("Switch between Quiet Mode options"), "QuietModeToggle", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::QuietModeToggle), {QKeySequence(Qt::Key_VolumeMute)}});
+        addShortcut({tr("Play/Pause"), tr("Play or pause the current media player"), "MediaPlayPause", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaPlayPause), {QKeySequence(Qt::Key_MediaPlay), QKeySequence(Qt::Key_MediaPause)}});
+        addShortcut({tr("Next Track"), tr("Skip to the next track in the current media player"), "MediaNext", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaNext), {QKeySequence(Qt::Key_MediaNext)}});
+        addShortcut({tr("Previous Track"), tr("Go back to the previous track in the current media player"), "MediaPrevious", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaPrevious), {QKeySequence(Qt::Key_MediaPrevious)}});
+        addShortcut({tr("Stop"), tr("Stop the current media player"), "MediaStop", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaStop), {QKeySequence(Qt::Key_MediaStop)}});
 
         addSection(tr("Keyboard"));
         addShortcut({tr("Next Layout"), tr("Switch to the next keyboard layout"), "NextKbdLayout", GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::NextKeyboardLayout), {QKeySequence(Qt::META | Qt::Key_Return)}});
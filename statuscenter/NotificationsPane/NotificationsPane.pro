@@ -68,13 +68,16 @@ HEADERS += \
     kjob/jobviewserver_adaptor.h \
     notificationsWidget/mediaplayernotification.h \
     notificationsWidget/notificationappgroup.h \
+    notificationsWidget/notificationhistory.h \
     notificationsWidget/notificationobject.h \
     notificationsWidget/notificationpanel.h \
     notificationsWidget/notificationpopup.h \
+    notificationsWidget/notificationrules.h \
     notificationsWidget/notificationsdbusadaptor.h \
     notificationsWidget/notificationswidget.h \
     kjob/jobviewwidget.h \
     settings/settingspane.h \
+    settings/notificationruledialog.h \
     settings/applicationnotificationmodel.h
 
 SOURCES += \
@@ -85,13 +88,16 @@ SOURCES += \
     kjob/jobviewserver_adaptor.cpp \
     notificationsWidget/mediaplayernotification.cpp \
     notificationsWidget/notificationappgroup.cpp \
+    notificationsWidget/notificationhistory.cpp \
     notificationsWidget/notificationobject.cpp \
     notificationsWidget/notificationpanel.cpp \
     notificationsWidget/notificationpopup.cpp \
+    notificationsWidget/notificationrules.cpp \
     notificationsWidget/notificationsdbusadaptor.cpp \
     notificationsWidget/notificationswidget.cpp \
     kjob/jobviewwidget.cpp \
     settings/settingspane.cpp \
+    settings/notificationruledialog.cpp \
     settings/applicationnotificationmodel.cpp
 
 FORMS += \
@@ -23,15 +23,27 @@
 
 #include <application.h>
 #include <QDBusPendingCallWatcher>
+#include <QDBusObjectPath>
 #include <the-libs_global.h>
+#include <QPointer>
+#include <mpris/albumartcache.h>
 
 struct MediaPlayerNotificationPrivate {
-    QNetworkAccessManager mgr;
+    QString albumArt;
+    QString albumArtRevision;
     QPalette defaultPal;
 
     MprisPlayerPtr service;
+    QTimer* positionTimer;
 };
 
+static QString trackRevision(MetadataMap metadata) {
+    //Players reuse art URLs across tracks, so the same URL only means the same art on the same track
+    QVariant trackId = metadata.value("mpris:trackid");
+    QString id = trackId.userType() == qMetaTypeId<QDBusObjectPath>() ? trackId.value<QDBusObjectPath>().path() : trackId.toString();
+    return QStringList({id, metadata.value("xesam:title").toString(), metadata.value("xesam:album").toString()}).join("\n");
+}
+
 MediaPlayerNotification::MediaPlayerNotification(MprisPlayerPtr service, QWidget *parent) :
     QFrame(parent),
     ui(new Ui::MediaPlayerNotification)
@@ -58,7 +70,8 @@ MediaPlayerNotification::MediaPlayerNotification(MprisPlayerPtr service, QWidget
     setDetails(d->service->metadata().value("xesam:title", d->service->identity()).toString(),
                d->service->metadata().value("xesam:artist").toStringList().join(", "),
                d->service->metadata().value("xesam:album").toString(),
-               d->service->metadata().value("xesam:albumArt").toString());
+               d->service->metadata().value("mpris:artUrl").toString(),
+               trackRevision(d->service->metadata()));
     ui->position->setMaximum(static_cast<int>(d->service->metadata().value("mpris:length").toUInt()));
     ui->position->setEnabled(d->service->canSeek());
     updatePosition(d->service->position());
@@ -69,39 +82,51 @@ MediaPlayerNotification::MediaPlayerNotification(MprisPlayerPtr service, QWidget
         ui->playPauseButton->setIcon(QIcon::fromTheme("media-playback-start"));
     }
 
-    connect(d->service.data(), &MprisPlayer::canQuitChanged, this, [=] {
-        ui->closeButton->setEnabled(d->service->canQuit());
-    });
-    connect(d->service.data(), &MprisPlayer::identityChanged, this, [=] {
-        ui->appName->setText(d->service->identity());
-    });
-    connect(d->service.data(), &MprisPlayer::metadataChanged, this, [=] {
-        setDetails(d->service->metadata().value("xesam:title", d->service->identity()).toString(),
-                   d->service->metadata().value("xesam:artist").toStringList().join(", "),
-                   d->service->metadata().value("xesam:album").toString(),
-                   d->service->metadata().value("mpris:artUrl").toString());
-
-        ui->position->setMaximum(static_cast<int>(d->service->metadata().value("mpris:length").toUInt()));
-    });
-    connect(d->service.data(), &MprisPlayer::playbackStatusChanged, this, [=] {
-        if (d->service->playbackStatus() == MprisPlayer::Playing) {
-            ui->playPauseButton->setIcon(QIcon::fromTheme("media-playback-pause"));
-        } else {
-            ui->playPauseButton->setIcon(QIcon::fromTheme("media-playback-start"));
+    connect(d->service.data(), &MprisPlayer::stateChanged, this, [=](MprisPlayer::StateProperties changed) {
+        if (changed.testFlag(MprisPlayer::CanQuitProperty)) {
+            ui->closeButton->setEnabled(d->service->canQuit());
+        }
+        if (changed.testFlag(MprisPlayer::IdentityProperty)) {
+            ui->appName->setText(d->service->identity());
+        }
+        if (changed.testFlag(MprisPlayer::MetadataProperty) || changed.testFlag(MprisPlayer::IdentityProperty)) {
+            MetadataMap metadata = d->service->metadata();
+            setDetails(metadata.value("xesam:title", d->service->identity()).toString(),
+                       metadata.value("xesam:artist").toStringList().join(", "),
+                       metadata.value("xesam:album").toString(),
+                       metadata.value("mpris:artUrl").toString(),
+                       trackRevision(metadata));
+
+            ui->position->setMaximum(static_cast<int>(metadata.value("mpris:length").toUInt()));
+        }
+        if (changed.testFlag(MprisPlayer::PlaybackStatusProperty)) {
+            if (d->service->playbackStatus() == MprisPlayer::Playing) {
+                ui->playPauseButton->setIcon(QIcon::fromTheme("media-playback-pause"));
+            } else {
+                ui->playPauseButton->setIcon(QIcon::fromTheme("media-playback-start"));
+            }
+            updatePositionTimer();
+        }
+        if (changed.testFlag(MprisPlayer::PlaybackStatusProperty) || changed.testFlag(MprisPlayer::MetadataProperty) || changed.testFlag(MprisPlayer::RateProperty)) {
+            updatePosition(d->service->position());
+        }
+        if (changed.testFlag(MprisPlayer::CanSeekProperty)) {
+            ui->position->setEnabled(d->service->canSeek());
         }
-    });
-    connect(d->service.data(), &MprisPlayer::canSeekChanged, this, [=] {
-        ui->position->setEnabled(d->service->canSeek());
     });
     connect(d->service.data(), &MprisPlayer::seeked, this, [=](qint64 position) {
         updatePosition(position);
     });
+    connect(d->service.data(), &MprisPlayer::positionResynced, this, [=](qint64 position) {
+        updatePosition(position);
+    });
     connect(d->service.data(), &MprisPlayer::gone, this, &MediaPlayerNotification::deleteLater);
 
-    QTimer* t = new QTimer(this);
-    t->setInterval(1000);
-    connect(t, &QTimer::timeout, this, QOverload<>::of(&MediaPlayerNotification::updatePosition));
-    t->start();
+    //The player interpolates its position locally, so ticking the seek bar costs no D-Bus traffic
+    //It only ticks while someone can see it; showEvent starts it
+    d->positionTimer = new QTimer(this);
+    d->positionTimer->setInterval(250);
+    connect(d->positionTimer, &QTimer::timeout, this, QOverload<>::of(&MediaPlayerNotification::updatePosition));
 }
 
 MediaPlayerNotification::~MediaPlayerNotification()
@@ -110,6 +135,27 @@ MediaPlayerNotification::~MediaPlayerNotification()
     delete ui;
 }
 
+void MediaPlayerNotification::showEvent(QShowEvent* event) {
+    QFrame::showEvent(event);
+
+    //The position kept moving while we were hidden
+    updatePosition();
+    updatePositionTimer();
+}
+
+void MediaPlayerNotification::hideEvent(QHideEvent* event) {
+    QFrame::hideEvent(event);
+    updatePositionTimer();
+}
+
+void MediaPlayerNotification::updatePositionTimer() {
+    if (isVisible() && d->service->playbackStatus() == MprisPlayer::Playing) {
+        d->positionTimer->start();
+    } else {
+        d->positionTimer->stop();
+    }
+}
+
 //void MediaPlayerNotification::updateMpris(QString interfaceName, QMap<QString, QVariant> properties, QStringList changedProperties) {
 //    if (interfaceName == "org.mpris.MediaPlayer2.Player") {
 //        if (properties.keys().contains("Metadata")) {
@@ -178,7 +224,7 @@ MediaPlayerNotification::~MediaPlayerNotification()
 
 //}
 
-void MediaPlayerNotification::setDetails(QString title, QString artist, QString album, QString albumArt) {
+void MediaPlayerNotification::setDetails(QString title, QString artist, QString album, QString albumArt, QString albumArtRevision) {
     if (ui->detailsLabel->text() != title) {
         updatePosition(0);
         ui->detailsLabel->setText(title);
@@ -197,69 +243,76 @@ void MediaPlayerNotification::setDetails(QString title, QString artist, QString
         ui->supplementaryLabel->setText(artist + " · " + album);
     }
 
+    if (albumArt == d->albumArt && albumArtRevision == d->albumArtRevision) return; //Same artwork as before
+    d->albumArt = albumArt;
+    d->albumArtRevision = albumArtRevision;
+
     ui->albumArt->setPixmap(QIcon::fromTheme("audio").pixmap(48, 48));
     this->setPalette(d->defaultPal);
     if (albumArt != "") {
-        QNetworkRequest req((QUrl(albumArt)));
-        QNetworkReply* reply = d->mgr.get(req);
-        connect(reply, &QNetworkReply::finished, [=] {
-            if (reply->error() == QNetworkReply::NoError) {
-                QImage image = QImage::fromData(reply->readAll());
-                if (!image.isNull()) {
-                    image = image.scaled(48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-                    qulonglong red = 0, green = 0, blue = 0;
-
-                    QPalette pal = d->defaultPal;
-                    int totalPixels = 0;
-                    for (int i = 0; i < image.width(); i++) {
-                        for (int j = 0; j < image.height(); j++) {
-                            QColor c = image.pixelColor(i, j);
-                            if (c.alpha() != 0) {
-                                red += c.red();
-                                green += c.green();
-                                blue += c.blue();
-                                totalPixels++;
-                            }
-                        }
-                    }
-
-                    QColor c;
-                    int averageCol = (pal.color(QPalette::Window).red() + pal.color(QPalette::Window).green() + pal.color(QPalette::Window).blue()) / 3;
-
-                    if (totalPixels == 0) {
-                        if (averageCol < 127) {
-                            c = pal.color(QPalette::Window).darker(200);
-                        } else {
-                            c = pal.color(QPalette::Window).lighter(200);
-                        }
-                    } else {
-                        c = QColor(red / totalPixels, green / totalPixels, blue / totalPixels);
-
-                        if (averageCol < 127) {
-                            c = c.darker(200);
-                        } else {
-                            c = c.lighter(200);
-                        }
-                    }
-
-                    pal.setColor(QPalette::Window, c);
-                    this->setPalette(pal);
-
-                    QImage rounded(48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling(), QImage::Format_ARGB32);
-                    rounded.fill(Qt::transparent);
-                    QPainter p(&rounded);
-                    p.setRenderHint(QPainter::Antialiasing);
-                    p.setBrush(QBrush(image));
-                    p.setPen(Qt::transparent);
-                    p.drawRoundedRect(0, 0, 48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling(), 40, 40, Qt::RelativeSize);
-
-                    ui->albumArt->setPixmap(QPixmap::fromImage(rounded));
-                }
+        //Decoding and scaling happens off the GUI thread; recently seen artwork comes straight from memory
+        QSize artSize(48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling());
+        QImage image = AlbumArtCache::cachedAlbumArt(albumArt, artSize, albumArtRevision);
+        if (!image.isNull()) {
+            setAlbumArt(image);
+        } else {
+            QPointer<MediaPlayerNotification> notification(this);
+            AlbumArtCache::albumArt(albumArt, artSize, albumArtRevision)->then([=](QImage image) {
+                if (notification.isNull() || d->albumArt != albumArt || d->albumArtRevision != albumArtRevision) return; //Track changed in the meantime
+                setAlbumArt(image);
+            });
+        }
+    }
+}
+
+void MediaPlayerNotification::setAlbumArt(QImage image) {
+    qulonglong red = 0, green = 0, blue = 0;
+
+    QPalette pal = d->defaultPal;
+    int totalPixels = 0;
+    for (int i = 0; i < image.width(); i++) {
+        for (int j = 0; j < image.height(); j++) {
+            QColor c = image.pixelColor(i, j);
+            if (c.alpha() != 0) {
+                red += c.red();
+                green += c.green();
+                blue += c.blue();
+                totalPixels++;
             }
-            reply->deleteLater();
-        });
+        }
+    }
+
+    QColor c;
+    int averageCol = (pal.color(QPalette::Window).red() + pal.color(QPalette::Window).green() + pal.color(QPalette::Window).blue()) / 3;
+
+    if (totalPixels == 0) {
+        if (averageCol < 127) {
+            c = pal.color(QPalette::Window).darker(200);
+        } else {
+            c = pal.color(QPalette::Window).lighter(200);
+        }
+    } else {
+        c = QColor(red / totalPixels, green / totalPixels, blue / totalPixels);
+
+        if (averageCol < 127) {
+            c = c.darker(200);
+        } else {
+            c = c.lighter(200);
+        }
     }
+
+    pal.setColor(QPalette::Window, c);
+    this->setPalette(pal);
+
+    QImage rounded(48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling(), QImage::Format_ARGB32);
+    rounded.fill(Qt::transparent);
+    QPainter p(&rounded);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setBrush(QBrush(image));
+    p.setPen(Qt::transparent);
+    p.drawRoundedRect(0, 0, 48 * theLibsGlobal::getDPIScaling(), 48 * theLibsGlobal::getDPIScaling(), 40, 40, Qt::RelativeSize);
+
+    ui->albumArt->setPixmap(QPixmap::fromImage(rounded));
 }
 
 void MediaPlayerNotification::on_backButton_clicked()
@@ -284,10 +337,7 @@ void MediaPlayerNotification::on_closeButton_clicked()
 
 void MediaPlayerNotification::updatePosition() {
     if (d->service->playbackStatus() == MprisPlayer::Playing) {
-        ui->position->blockSignals(true);
-        int currentValue = ui->position->value();
-        ui->position->setValue(currentValue + qRound((d->service->rate() * 1000000)));
-        ui->position->blockSignals(false);
+        updatePosition(d->service->position());
     }
 }
 
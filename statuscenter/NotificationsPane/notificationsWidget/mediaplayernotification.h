@@ -71,7 +71,12 @@ class MediaPlayerNotification : public QFrame
         Ui::MediaPlayerNotification *ui;
         MediaPlayerNotificationPrivate* d;
 
-        void setDetails(QString title, QString artist, QString album, QString albumArt);
+        void setDetails(QString title, QString artist, QString album, QString albumArt, QString albumArtRevision);
+        void setAlbumArt(QImage image);
+        void updatePositionTimer();
+
+        void showEvent(QShowEvent* event);
+        void hideEvent(QHideEvent* event);
 };
 
 #endif // MEDIAPLAYERNOTIFICATION_H
@@ -72,7 +72,7 @@ void NotificationAppGroup::AddNotification(NotificationObject *object) {
         updateCollapsedCounter();
     });
 
-    QTimer::singleShot(100, [=] {
+    QTimer::singleShot(100, panel, [=] {
         if (notifications.count() <= 5 || expanded) {
             panel->expandHide();
         }
@@ -111,13 +111,42 @@ void NotificationAppGroup::on_closeAllNotificationsButton_clicked()
 
 void NotificationAppGroup::clearAll() {
     while (!notifications.isEmpty()) {
-        notifications.takeFirst()->getObject()->dismiss();
+        NotificationObject* object = notifications.takeFirst()->getObject();
+        if (object != nullptr) object->dismiss();
     }
 }
 
 
+int NotificationAppGroup::setFilter(QString filter) {
+    this->filter = filter;
+
+    int matches = 0;
+    for (int i = 0; i < notifications.count(); i++) {
+        NotificationPanel* panel = notifications.at(i);
+        if (filter.isEmpty()) {
+            panel->setVisible(true);
+            if (i < 5 || expanded) {
+                panel->expandHide();
+            } else {
+                panel->collapseHide();
+            }
+        } else if (panel->matches(filter)) {
+            //Show every match, even ones that would normally be collapsed
+            panel->setVisible(true);
+            panel->expandHide();
+            matches++;
+        } else {
+            panel->setVisible(false);
+        }
+    }
+
+    this->setVisible(filter.isEmpty() || matches > 0);
+    updateCollapsedCounter();
+    return matches;
+}
+
 void NotificationAppGroup::updateCollapsedCounter() {
-    if (notifications.count() > 5) {
+    if (notifications.count() > 5 && filter.isEmpty()) {
         if (expanded) {
             ui->collapsedLabel->setText(tr("Collapse Notifications"));
             ui->expandNotificationsButton->setIcon(QIcon::fromTheme("go-up"));
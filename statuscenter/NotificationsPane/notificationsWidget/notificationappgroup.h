@@ -40,6 +40,7 @@ public:
     QString getIdentifier();
 
     int count();
+    int setFilter(QString filter);
 
 public slots:
     void AddNotification(NotificationObject* object);
@@ -66,6 +67,7 @@ private:
     QIcon appIcon;
 
     bool expanded = false;
+    QString filter;
 
     QList<NotificationPanel*> notifications;
 };
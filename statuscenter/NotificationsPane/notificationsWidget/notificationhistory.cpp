@@ -0,0 +1,309 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#include "notificationhistory.h"
+#include "notificationobject.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QTimer>
+#include <QUuid>
+#include <QSettings>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#include <tpromise.h>
+#include <algorithm>
+
+//Hints worth keeping once the sender is gone; anything else (image data, actions) can't outlive the session
+const QStringList persistentHints = {"desktop-entry", "category", "urgency", "x-thesuite-timercomplete"};
+
+struct NotificationHistoryPrivate {
+    NotificationHistory* instance = nullptr;
+    QString logPath;
+
+    struct Tracked {
+        QString key;
+        QString app;
+        QDateTime date;
+    };
+
+    //Every notification in the pane, oldest first
+    QMultiMap<QDateTime, NotificationObject*> live;
+    QHash<NotificationObject*, Tracked> tracked;
+    QHash<QString, int> appCounts;
+
+    //Records waiting to be appended to the log
+    QStringList pendingLines;
+    int logLines = 0;
+    bool compactRequired = false;
+    bool loaded = false;
+    bool flushPending = false;
+    bool writeInFlight = false;
+
+    //Held by the worker for as long as a write is touching the log
+    QSemaphore writeSlot{1};
+};
+
+NotificationHistoryPrivate* NotificationHistory::d = new NotificationHistoryPrivate();
+
+NotificationHistory::NotificationHistory(QObject *parent) : QObject(parent)
+{
+    d->logPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/notifications/history.log";
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [=] {
+        //Don't lose anything still waiting for the timer
+        if (!d->loaded || d->pendingLines.isEmpty()) return;
+
+        //Let a write that's already under way finish first so these records land after it
+        d->writeSlot.acquire();
+        QDir::root().mkpath(QFileInfo(d->logPath).absolutePath());
+        QFile file(d->logPath);
+        if (file.open(QFile::Append)) {
+            file.write(d->pendingLines.join("\n").append("\n").toUtf8());
+            file.close();
+        }
+        d->writeSlot.release();
+        d->pendingLines.clear();
+    });
+}
+
+NotificationHistory* NotificationHistory::instance() {
+    if (d->instance == nullptr) d->instance = new NotificationHistory();
+    return d->instance;
+}
+
+void NotificationHistory::load() {
+    QString logPath = d->logPath;
+    QSettings settings;
+    int perApp = settings.value("notifications/historyPerApp", 20).toInt();
+    int limit = settings.value("notifications/historyLimit", 100).toInt();
+
+    (new tPromise<QList<Entry>>([=](QString& error) -> QList<Entry> {
+        Q_UNUSED(error)
+
+        //Replay the log; later records supersede earlier ones with the same key
+        QMap<QString, Entry> entries;
+        QFile file(logPath);
+        if (file.open(QFile::ReadOnly)) {
+            while (!file.atEnd()) {
+                QJsonObject record = QJsonDocument::fromJson(file.readLine()).object();
+                QString key = record.value("key").toString();
+                if (key.isEmpty()) continue;
+
+                if (record.value("op").toString() == "remove") {
+                    entries.remove(key);
+                } else {
+                    Entry entry;
+                    entry.key = key;
+                    entry.appName = record.value("app").toString();
+                    entry.appIcon = record.value("icon").toString();
+                    entry.summary = record.value("summary").toString();
+                    entry.body = record.value("body").toString();
+                    entry.hints = record.value("hints").toObject().toVariantMap();
+                    entry.date = QDateTime::fromMSecsSinceEpoch(record.value("date").toVariant().toLongLong(), Qt::UTC);
+                    entries.insert(key, entry);
+                }
+            }
+            file.close();
+        }
+
+        QList<Entry> sorted = entries.values();
+        std::sort(sorted.begin(), sorted.end(), [](const Entry& first, const Entry& second) {
+            return first.date < second.date;
+        });
+
+        //Apply the caps here so we never build widgets just to throw them away
+        QList<Entry> kept;
+        QMap<QString, int> appCounts;
+        for (int i = sorted.count() - 1; i >= 0 && kept.count() < limit; i--) {
+            Entry entry = sorted.at(i);
+            if (appCounts.value(entry.appName) >= perApp) continue;
+            appCounts[entry.appName]++;
+            kept.prepend(entry);
+        }
+        return kept;
+    }))->then([=](QList<Entry> entries) {
+        emit loaded(entries);
+        d->loaded = true;
+
+        //Rewrite the log so it only holds what was restored
+        d->compactRequired = true;
+        flush();
+    });
+}
+
+void NotificationHistory::add(NotificationObject* object, QString key) {
+    if (d->tracked.contains(object)) return;
+    if (key.isEmpty()) key = QUuid::createUuid().toString();
+
+    //Remember what we filed the notification under in case it's replaced with different details later
+    NotificationHistoryPrivate::Tracked tracked;
+    tracked.key = key;
+    tracked.app = object->getAppIdentifier();
+    tracked.date = object->getDate();
+    d->tracked.insert(object, tracked);
+    d->live.insert(tracked.date, object);
+    d->appCounts[tracked.app]++;
+
+    update(object);
+}
+
+void NotificationHistory::update(NotificationObject* object) {
+    if (!d->tracked.contains(object)) return;
+    if (object->getHints().value("transient", false).toBool()) return;
+
+    d->pendingLines.append(record(object));
+    scheduleFlush();
+}
+
+void NotificationHistory::remove(NotificationObject* object) {
+    if (!d->tracked.contains(object)) return;
+    NotificationHistoryPrivate::Tracked tracked = d->tracked.take(object);
+    d->live.remove(tracked.date, object);
+    if (--d->appCounts[tracked.app] == 0) d->appCounts.remove(tracked.app);
+
+    QJsonObject record;
+    record.insert("op", "remove");
+    record.insert("key", tracked.key);
+
+    d->pendingLines.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    scheduleFlush();
+}
+
+QList<NotificationObject*> NotificationHistory::overflow() {
+    QSettings settings;
+    int perApp = settings.value("notifications/historyPerApp", 20).toInt();
+    int limit = settings.value("notifications/historyLimit", 100).toInt();
+
+    //Usually nothing is over the limits, which the running counts tell us without walking the history
+    bool appOverLimit = false;
+    for (int count : d->appCounts) {
+        if (count > perApp) appOverLimit = true;
+    }
+    if (d->live.count() <= limit && !appOverLimit) return QList<NotificationObject*>();
+
+    //Walk from newest to oldest so that the oldest notifications are the ones that go
+    QList<NotificationObject*> overflow;
+    QHash<QString, int> appCounts;
+    int kept = 0;
+    for (auto i = d->live.constEnd(); i != d->live.constBegin();) {
+        i--;
+        NotificationObject* object = i.value();
+        QString app = d->tracked.value(object).app;
+        if (kept >= limit || appCounts.value(app) >= perApp) {
+            overflow.append(object);
+        } else {
+            appCounts[app]++;
+            kept++;
+        }
+    }
+    return overflow;
+}
+
+QString NotificationHistory::record(NotificationObject* object) {
+    QVariantMap hints;
+    QVariantMap objectHints = object->getHints();
+    for (QString hint : persistentHints) {
+        if (objectHints.contains(hint)) hints.insert(hint, objectHints.value(hint));
+    }
+
+    QJsonObject record;
+    record.insert("op", "add");
+    record.insert("key", d->tracked.value(object).key);
+    record.insert("app", object->getAppName());
+    record.insert("icon", object->getAppIconName());
+    record.insert("summary", object->getSummary());
+    record.insert("body", object->getBody());
+    record.insert("hints", QJsonObject::fromVariantMap(hints));
+    record.insert("date", object->getDate().toMSecsSinceEpoch());
+    return QJsonDocument(record).toJson(QJsonDocument::Compact);
+}
+
+void NotificationHistory::scheduleFlush() {
+    if (d->flushPending) return;
+    d->flushPending = true;
+    QTimer::singleShot(1000, this, [=] {
+        d->flushPending = false;
+        flush();
+    });
+}
+
+void NotificationHistory::flush() {
+    //Nothing touches the log until it has been read back
+    if (!d->loaded) return;
+
+    if (d->writeInFlight) {
+        scheduleFlush();
+        return;
+    }
+
+    //Compact once superseded records outweigh live ones
+    bool compact = d->compactRequired || d->logLines > d->live.count() * 2 + 50;
+    d->compactRequired = false;
+
+    QStringList lines;
+    if (compact) {
+        for (NotificationObject* object : d->live) {
+            if (object->getHints().value("transient", false).toBool()) continue;
+            lines.append(record(object));
+        }
+        d->logLines = lines.count();
+    } else {
+        if (d->pendingLines.isEmpty()) return;
+        lines = d->pendingLines;
+        d->logLines += lines.count();
+    }
+    d->pendingLines.clear();
+
+    QString logPath = d->logPath;
+    d->writeInFlight = true;
+    d->writeSlot.acquire();
+    (new tPromise<bool>([=](QString& error) -> bool {
+        Q_UNUSED(error)
+        QDir::root().mkpath(QFileInfo(logPath).absolutePath());
+
+        bool written = false;
+        QByteArray data = lines.isEmpty() ? QByteArray() : lines.join("\n").append("\n").toUtf8();
+        if (compact) {
+            QSaveFile file(logPath);
+            if (file.open(QSaveFile::WriteOnly)) {
+                file.write(data);
+                written = file.commit();
+            }
+        } else {
+            QFile file(logPath);
+            if (file.open(QFile::Append)) {
+                file.write(data);
+                file.close();
+                written = true;
+            }
+        }
+
+        d->writeSlot.release();
+        return written;
+    }))->then([=](bool) {
+        d->writeInFlight = false;
+    });
+}
@@ -0,0 +1,68 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef NOTIFICATIONHISTORY_H
+#define NOTIFICATIONHISTORY_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QVariantMap>
+#include <debuginformationcollector.h>
+
+class NotificationObject;
+
+struct NotificationHistoryPrivate;
+class NotificationHistory : public QObject
+{
+        Q_OBJECT
+    public:
+        struct Entry {
+            QString key;
+            QString appName;
+            QString appIcon;
+            QString summary;
+            QString body;
+            QVariantMap hints;
+            QDateTime date;
+        };
+
+        static NotificationHistory* instance();
+
+        void load();
+
+        void add(NotificationObject* object, QString key = "");
+        void update(NotificationObject* object);
+        void remove(NotificationObject* object);
+
+        QList<NotificationObject*> overflow();
+
+    signals:
+        void loaded(QList<NotificationHistory::Entry> entries);
+
+    private:
+        explicit NotificationHistory(QObject *parent = T_QOBJECT_ROOT);
+        static NotificationHistoryPrivate* d;
+
+        QString record(NotificationObject* object);
+        void scheduleFlush();
+        void flush();
+};
+
+#endif // NOTIFICATIONHISTORY_H
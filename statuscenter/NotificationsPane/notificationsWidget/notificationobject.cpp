@@ -23,8 +23,11 @@
 
 #include "soundengine.h"
 #include <quietmodedaemon.h>
+#include <tpromise.h>
+#include <QPointer>
 
 int NotificationObject::currentId = 0;
+QHash<QString, QIcon> NotificationObject::appIcons = QHash<QString, QIcon>();
 
 const QDBusArgument &operator<<(QDBusArgument &argument, const ImageData &d) {
     argument.beginStructure();
@@ -35,7 +38,14 @@ const QDBusArgument &operator<<(QDBusArgument &argument, const ImageData &d) {
 
 const QDBusArgument &operator>>(const QDBusArgument &argument, ImageData &d) {
     argument.beginStructure();
-    argument >> d.width >> d.height >> d.rowstride >> d.alpha >> d.bitsPerSample >> d.channels >> d.data;
+    argument >> d.width >> d.height >> d.rowstride >> d.alpha >> d.bitsPerSample >> d.channels;
+
+    //Only copy the pixels out of the message if the header describes an image we can show
+    if (d.width > 0 && d.height > 0 && d.width <= 4096 && d.height <= 4096 &&
+            d.bitsPerSample == 8 && (d.channels == 3 || d.channels == 4) &&
+            d.rowstride >= d.width * d.channels && static_cast<qint64>(d.rowstride) * d.height <= 64 * 1024 * 1024) {
+        argument >> d.data;
+    }
     argument.endStructure();
     return argument;
 }
@@ -44,12 +54,6 @@ NotificationObject::NotificationObject(QString app_name, QString app_icon, QStri
     currentId++;
     this->id = currentId;
 
-    dialog = new NotificationPopup(currentId);
-    connect(dialog, SIGNAL(actionClicked(QString)), this, SIGNAL(actionClicked(QString)));
-    connect(dialog, &NotificationPopup::notificationClosed, [=](uint reason) {
-        emit closed((NotificationCloseReason) reason);
-    });
-
     setParameters(app_name, app_icon, summary, body, actions, hints, expire_timeout);
     this->date = QDateTime::currentDateTimeUtc();
 }
@@ -63,16 +67,27 @@ void NotificationObject::setParameters(QString &app_name, QString &app_icon, QSt
     this->hints = hints;
     this->timeout = expire_timeout;
 
-    appIc = QIcon::fromTheme("generic-app");
-    if (appIcon != "" && QIcon::hasThemeIcon(appIcon)) {
-        appIc = QIcon::fromTheme(appIcon);
-    } else if (QIcon::hasThemeIcon(appName.toLower().replace(" ", "-"))) {
-        appIc = QIcon::fromTheme(appName.toLower().replace(" ", "-"));
-    } else if (QIcon::hasThemeIcon(appName.toLower().replace(" ", ""))) {
-        appIc = QIcon::fromTheme(appName.toLower().replace(" ", ""));
+    //Resolve the server default here so a popup refreshed in place doesn't see -1
+    if (timeout < 0) {
+        timeout = 5000;
+    }
+
+    //Icon theme lookups are slow, so only resolve each app's icon once
+    QString iconKey = appIcon + "\n" + appName + "\n" + hints.value("desktop-entry", "").toString();
+    if (appIcons.contains(iconKey)) {
+        appIc = appIcons.value(iconKey);
     } else {
-        NotificationsPermissionEngine permissions(appName, hints.value("desktop-entry", "").toString());
-        appIc = permissions.appIcon();
+        if (appIcon != "" && QIcon::hasThemeIcon(appIcon)) {
+            appIc = QIcon::fromTheme(appIcon);
+        } else if (QIcon::hasThemeIcon(appName.toLower().replace(" ", "-"))) {
+            appIc = QIcon::fromTheme(appName.toLower().replace(" ", "-"));
+        } else if (QIcon::hasThemeIcon(appName.toLower().replace(" ", ""))) {
+            appIc = QIcon::fromTheme(appName.toLower().replace(" ", ""));
+        } else {
+            NotificationsPermissionEngine permissions(appName, hints.value("desktop-entry", "").toString());
+            appIc = permissions.appIcon();
+        }
+        appIcons.insert(iconKey, appIc);
     }
 
     bigIc = QIcon();
@@ -111,60 +126,66 @@ void NotificationObject::setParameters(QString &app_name, QString &app_icon, QSt
 
     actionNamesAreIcons = hints.value("action-icons", false).toBool();
 
-    /*if (hints.contains("image-data")) {
-        QDBusArgument imageDataArg = hints.value("image-data").value<QDBusArgument>();
-        ImageData i;
-        imageDataArg >> i;
-        char* data = i.data.data();
+    loadImageData();
 
-        /*QImage image(i.width, i.height, QImage::Format_ARGB32);
-        int lineWidth = i.bitsPerSample * i.channels * i.width;
-        for (int x = 0; x < i.height; x++) {
-            memcpy(image.scanLine(x), i.data.data() + (lineWidth * x), lineWidth);
-        }
+    emit parametersUpdated();
+}
 
-        bigIc = QIcon(QPixmap::fromImage(image));
+void NotificationObject::loadImageData() {
+    imageRequest++;
 
-        QImage image(i.width, i.height, QImage::Format_ARGB32);
+    QString hint;
+    for (QString name : {"image-data", "image_data", "icon_data"}) {
+        if (hints.contains(name)) {
+            hint = name;
+            break;
+        }
+    }
+    if (hint.isEmpty() || !hints.value(hint).canConvert<QDBusArgument>()) return;
 
-        for (int y = 0; y < i.height; y++) {
-            for (int x = 0; x < i.width; x++) {
-                unsigned long a, r, g, b;
+    ImageData imageData;
+    hints.value(hint).value<QDBusArgument>() >> imageData;
 
-                a = (data[(int) (y * i.width + x + 0)]);
-                r = (data[(int) (y * i.width + x + 1)]);
-                g = (data[(int) (y * i.width + x + 2)]);
-                b = (data[(int) (y * i.width + x + 3)]);
+    //The last row doesn't need to be padded out to the full stride
+    if (imageData.data.isEmpty() || imageData.data.size() < imageData.rowstride * (imageData.height - 1) + imageData.width * imageData.channels) return;
 
-                QColor col = QColor(r, g, b, a);
+    QSize size = QSize(64, 64) * theLibsGlobal::getDPIScaling();
+    uint request = imageRequest;
+    QPointer<NotificationObject> object = this;
+    (new tPromise<QImage>([=](QString& error) -> QImage {
+        Q_UNUSED(error)
 
-                image.setPixelColor(x, y, col);
-            }
+        QImage::Format format;
+        if (imageData.channels == 3) {
+            format = QImage::Format_RGB888;
+        } else if (imageData.alpha) {
+            format = QImage::Format_RGBA8888;
+        } else {
+            format = QImage::Format_RGBX8888;
         }
 
-        QPixmap iconPixmap(QPixmap::fromImage(image));//.scaled(16, 16, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-        bigIc = QIcon(iconPixmap);
-    }*/
+        //Wrap the buffer we already have and convert once, which also detaches from it
+        QImage image(reinterpret_cast<const uchar*>(imageData.data.constData()), imageData.width, imageData.height, imageData.rowstride, format);
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        if (image.width() > size.width() || image.height() > size.height()) {
+            image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        return image;
+    }))->then([=](QImage image) {
+        //Ignore this image if the notification has gone or has been replaced since
+        if (object.isNull() || object->imageRequest != request) return;
 
-    emit parametersUpdated();
+        object->bigIc = QIcon(QPixmap::fromImage(image));
+        emit object->parametersUpdated();
+    });
 }
 
-void NotificationObject::post() {
+void NotificationObject::post(bool showPopup) {
     NotificationsPermissionEngine permissions(appName, hints.value("desktop-entry", "").toString());
-    dialog->setHints(hints);
-    dialog->setApp(appName, appIc);
-    dialog->setSummary(summary);
-    dialog->setBody(body);
-    dialog->setActions(actions, actionNamesAreIcons);
-    dialog->setBigIcon(bigIc);
-
-    if (timeout < 0) {
-        timeout = 5000;
-    }
-    dialog->setTimeout(timeout);
 
-    if (permissions.showPopups() && !dialog->isVisible()) {
-        dialog->show();
+    if (showPopup && permissions.showPopups()) {
+        //The popup picks up our contents when it's our turn on screen
+        NotificationPopup::showNotification(this);
     }
 
     //Play sounds if requested
@@ -204,14 +225,16 @@ uint NotificationObject::getId() {
 }
 
 void NotificationObject::closeDialog() {
-    if (dialog->isVisible()) {
-        dialog->close();
-    }
+    NotificationPopup::hideNotification(this);
 }
 
 void NotificationObject::dismiss() {
+    close(Dismissed);
+}
+
+void NotificationObject::close(NotificationCloseReason reason) {
     closeDialog();
-    emit closed(Dismissed);
+    emit closed(reason);
 }
 
 QIcon NotificationObject::getAppIcon() {
@@ -237,3 +260,32 @@ QString NotificationObject::getBody() {
 QDateTime NotificationObject::getDate() {
     return this->date;
 }
+
+void NotificationObject::setDate(QDateTime date) {
+    this->date = date;
+    emit parametersUpdated();
+}
+
+QString NotificationObject::getAppIconName() {
+    return this->appIcon;
+}
+
+QIcon NotificationObject::getBigIcon() {
+    return bigIc;
+}
+
+QStringList NotificationObject::getActions() {
+    return this->actions;
+}
+
+bool NotificationObject::getActionNamesAreIcons() {
+    return this->actionNamesAreIcons;
+}
+
+QVariantMap NotificationObject::getHints() {
+    return this->hints;
+}
+
+int NotificationObject::getTimeout() {
+    return this->timeout;
+}
@@ -52,17 +52,26 @@ public:
     QString getSummary();
     QString getBody();
     QDateTime getDate();
+    void setDate(QDateTime date);
+    QString getAppIconName();
+    QIcon getBigIcon();
+    QStringList getActions();
+    bool getActionNamesAreIcons();
+    QVariantMap getHints();
+    int getTimeout();
 
 signals:
     void parametersUpdated();
     void actionClicked(QString key);
+    void replied(QString text);
     void closed(NotificationObject::NotificationCloseReason reason);
 
 public slots:
-    void post();
+    void post(bool showPopup = true);
     void setParameters(QString &app_name, QString &app_icon, QString &summary, QString &body, QStringList &actions, QVariantMap &hints, int expire_timeout);
     void closeDialog();
     void dismiss();
+    void close(NotificationObject::NotificationCloseReason reason);
 
 private:
     QString appName, appIcon, summary, body;
@@ -73,10 +82,12 @@ private:
     bool actionNamesAreIcons = false;
     QDateTime date;
 
-    NotificationPopup* dialog;
-
     QIcon appIc, bigIc;
     QSettings settings;
+    static QHash<QString, QIcon> appIcons;
+
+    void loadImageData();
+    uint imageRequest = 0;
 };
 
 #endif // NOTIFICATIONOBJECT_H
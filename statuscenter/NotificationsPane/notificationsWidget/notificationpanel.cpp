@@ -36,7 +36,7 @@ NotificationPanel::NotificationPanel(NotificationObject* object, QWidget *parent
     updateParameters();
     this->setFixedHeight(0);
 
-    QTimer* t = new QTimer();
+    QTimer* t = new QTimer(this);
     t->setInterval(60000);
     connect(t, SIGNAL(timeout()), this, SLOT(updateTime()));
     t->start();
@@ -48,6 +48,7 @@ NotificationPanel::~NotificationPanel()
 }
 
 void NotificationPanel::updateTime() {
+    if (object.isNull()) return;
     QDateTime elapsed = QDateTime::fromMSecsSinceEpoch(object->getDate().msecsTo(QDateTime::currentDateTimeUtc()), Qt::UTC);
 
     if (elapsed.date().day() > 1) {
@@ -99,6 +100,13 @@ NotificationObject* NotificationPanel::getObject() {
     return this->object;
 }
 
+bool NotificationPanel::matches(QString filter) {
+    if (object.isNull()) return false;
+    return object->getSummary().contains(filter, Qt::CaseInsensitive) ||
+            object->getBody().contains(filter, Qt::CaseInsensitive) ||
+            object->getAppName().contains(filter, Qt::CaseInsensitive);
+}
+
 void NotificationPanel::collapseHide() {
     tVariantAnimation* anim = new tVariantAnimation();
     anim->setStartValue(this->height());
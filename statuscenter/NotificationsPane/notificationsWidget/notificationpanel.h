@@ -24,6 +24,7 @@
 #include <QWidget>
 #include <QMouseEvent>
 #include <QTimer>
+#include <QPointer>
 #include "notificationobject.h"
 #include "tpropertyanimation.h"
 
@@ -40,6 +41,7 @@ public:
     ~NotificationPanel();
 
     NotificationObject* getObject();
+    bool matches(QString filter);
 
 public slots:
     void collapseHide();
@@ -64,7 +66,7 @@ private:
 
     void mouseReleaseEvent(QMouseEvent* event);
 
-    NotificationObject* object;
+    QPointer<NotificationObject> object;
 };
 
 #endif // NOTIFICATIONPANEL_H
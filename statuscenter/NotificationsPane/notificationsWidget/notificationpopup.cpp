@@ -24,10 +24,10 @@
 #include "notificationobject.h"
 #include <QScreen>
 
-NotificationPopup* NotificationPopup::currentlyShowingPopup = NULL;
-QList<NotificationPopup*> NotificationPopup::pendingPopups = QList<NotificationPopup*>();
+NotificationPopup* NotificationPopup::popup = nullptr;
+QList<QPointer<NotificationObject>> NotificationPopup::pendingNotifications = QList<QPointer<NotificationObject>>();
 
-NotificationPopup::NotificationPopup(int id, QWidget *parent) :
+NotificationPopup::NotificationPopup(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::NotificationPopup)
 {
@@ -39,7 +39,9 @@ NotificationPopup::NotificationPopup(int id, QWidget *parent) :
     ui->buttonsWidget->setFixedHeight(0);
     ui->downArrow->setPixmap(QIcon::fromTheme("go-down").pixmap(16 * theLibsGlobal::getDPIScaling(), 16 * theLibsGlobal::getDPIScaling()));
     ui->ContentsWidget->setFixedHeight(ui->bodyLabel->fontMetrics().height() + ui->ContentsWidget->layout()->contentsMargins().top());
-    this->id = id;
+    ui->progressBar->setVisible(false);
+    ui->replyWidget->setVisible(false);
+    connect(ui->replyBox, &QLineEdit::returnPressed, this, &NotificationPopup::on_sendReplyButton_clicked);
 
     this->layout()->removeWidget(ui->mainWidget);
 
@@ -85,75 +87,153 @@ NotificationPopup::~NotificationPopup()
     delete ui;
 }
 
-void NotificationPopup::show() {
-    if (currentlyShowingPopup != nullptr) {
-        currentlyShowingPopup->close();
-        //emit currentlyShowingPopup->notificationClosed(NotificationObject::Undefined);
-        pendingPopups.append(this);
+void NotificationPopup::showNotification(NotificationObject* notification) {
+    if (popup != nullptr && popup->notification == notification && !popup->closing) {
+        //The notification was replaced while it's on screen
+        popup->setNotification(notification);
+        return;
+    }
+
+    if (!pendingNotifications.contains(notification)) pendingNotifications.append(notification);
+
+    if (popup == nullptr) {
+        popup = new NotificationPopup();
+        showNextNotification();
     } else {
-        currentlyShowingPopup = this;
-        QRect screenGeometry = QApplication::screens().first()->geometry();
-        this->move(screenGeometry.topLeft().x(), screenGeometry.top() - this->height());
-        this->setFixedWidth(screenGeometry.width());
+        //Make way for the new notification
+        popup->close();
+    }
+}
 
-        textHeight = ui->bodyLabel->fontMetrics().boundingRect(QRect(0, 0, screenGeometry.width() - this->layout()->contentsMargins().left() - this->layout()->contentsMargins().right(), 10000), Qt::TextWordWrap | Qt::AlignLeft | Qt::AlignTop, ui->bodyLabel->text()).height();
+void NotificationPopup::hideNotification(NotificationObject* notification) {
+    pendingNotifications.removeAll(notification);
+    if (popup != nullptr && popup->notification == notification) {
+        popup->close();
+    }
+}
 
-        bool showDownArrow = false;
-        if (textHeight > ui->bodyLabel->fontMetrics().height()) {
-            showDownArrow = true;
-        }
-        if (actions.count() > 0) {
-            showDownArrow = true;
+void NotificationPopup::showNextNotification() {
+    while (!pendingNotifications.isEmpty() && pendingNotifications.first().isNull()) {
+        pendingNotifications.removeFirst();
+    }
+
+    if (pendingNotifications.isEmpty()) {
+        //Nothing else to show, so don't keep the window around
+        popup->deleteLater();
+        popup = nullptr;
+        return;
+    }
+
+    popup->setNotification(pendingNotifications.takeFirst());
+    popup->show();
+}
+
+void NotificationPopup::setNotification(NotificationObject* notification) {
+    if (this->notification != notification) {
+        if (!this->notification.isNull()) {
+            disconnect(this, nullptr, this->notification, nullptr);
+            disconnect(this->notification, nullptr, this, nullptr);
         }
-        ui->downContainer->setVisible(showDownArrow);
 
-        this->setFixedHeight(ui->mainWidget->sizeHint().height());
-        QDialog::show();
+        this->notification = notification;
+        connect(notification, &NotificationObject::parametersUpdated, this, [=] {
+            //Pick up images that finish decoding while we're on screen
+            if (!closing) setNotification(notification);
+        });
+        connect(this, &NotificationPopup::actionClicked, notification, &NotificationObject::actionClicked);
+        connect(this, &NotificationPopup::replied, notification, &NotificationObject::replied);
+        connect(this, &NotificationPopup::notificationClosed, notification, [=](uint reason) {
+            emit notification->closed((NotificationObject::NotificationCloseReason) reason);
+        });
+    }
+
+    setHints(notification->getHints());
+    setApp(notification->getAppName(), notification->getAppIcon());
+    setSummary(notification->getSummary());
+    setBody(notification->getBody());
+    setActions(notification->getActions(), notification->getActionNamesAreIcons());
+    setBigIcon(notification->getBigIcon());
+    setTimeout(notification->getTimeout());
+}
 
-        tPropertyAnimation* anim = new tPropertyAnimation(this, "geometry");
-        anim->setStartValue(this->geometry());
-        anim->setEndValue(QRect(this->x(), screenGeometry.y(), this->width(), this->height()));
-        anim->setDuration(500);
-        anim->setEasingCurve(QEasingCurve::OutCubic);
-        connect(anim, SIGNAL(finished()), anim, SLOT(deleteLater()));
-        anim->start();
+void NotificationPopup::show() {
+    //Reset anything the previous notification left behind
+    closing = false;
+    currentTouch = -1;
+    dismisserStopCount = 0;
+    ui->mainWidget->move(0, 0);
+    ui->buttonsWidget->setFixedHeight(0);
+    ui->ContentsWidget->setFixedHeight(ui->bodyLabel->fontMetrics().height() + ui->ContentsWidget->layout()->contentsMargins().top());
+    ui->downContainer->setFixedHeight(ui->downContainer->sizeHint().height());
+    ui->replyBox->clear();
 
-        if (settings.value("notifications/emphasiseApp", true).toBool()) {
-            coverWidget->move(0, 0);
-            coverWidget->resize(this->width(), this->height() - 1);
-            coverWidget->clearMask();
-            coverWidget->setVisible(true);
-            QTimer::singleShot(1000, [=] {
-                tVariantAnimation* anim = new tVariantAnimation();
-                QPoint origin = ui->appIcon->geometry().center();
+    QRect screenGeometry = QApplication::screens().first()->geometry();
+    this->move(screenGeometry.topLeft().x(), screenGeometry.top() - this->height());
+    this->setFixedWidth(screenGeometry.width());
 
-                int radius = qSqrt(qPow(this->width() - origin.x(), 2) + qPow(this->height() - origin.y(), 2));
-                anim->setStartValue(radius);
-                anim->setEndValue(1);
-                anim->setDuration(250);
-                anim->setEasingCurve(QEasingCurve::InCubic);
-                connect(anim, &tVariantAnimation::valueChanged, [=](QVariant value) {
-                    QRegion r(QRect(origin.x() - value.toInt(), origin.y() - value.toInt(), value.toInt() * 2, value.toInt() * 2), QRegion::Ellipse);
-                    coverWidget->setMask(r);
-                    this->repaint();
-                    ui->mainWidget->repaint();
-                });
-                connect(anim, &tVariantAnimation::finished, [=] {
-                    coverWidget->setVisible(false);
-                });
-                anim->start();
+    textHeight = ui->bodyLabel->fontMetrics().boundingRect(QRect(0, 0, screenGeometry.width() - this->layout()->contentsMargins().left() - this->layout()->contentsMargins().right(), 10000), Qt::TextWordWrap | Qt::AlignLeft | Qt::AlignTop, ui->bodyLabel->text()).height();
+
+    bool showDownArrow = false;
+    if (textHeight > ui->bodyLabel->fontMetrics().height()) {
+        showDownArrow = true;
+    }
+    if (actions.count() > 0 || !ui->replyWidget->isHidden()) {
+        showDownArrow = true;
+    }
+    ui->downContainer->setVisible(showDownArrow);
+
+    this->setFixedHeight(ui->mainWidget->sizeHint().height());
+    QDialog::show();
 
-                dismisser->start();
+    tPropertyAnimation* anim = new tPropertyAnimation(this, "geometry");
+    anim->setStartValue(this->geometry());
+    anim->setEndValue(QRect(this->x(), screenGeometry.y(), this->width(), this->height()));
+    anim->setDuration(500);
+    anim->setEasingCurve(QEasingCurve::OutCubic);
+    connect(anim, SIGNAL(finished()), anim, SLOT(deleteLater()));
+    anim->start();
+
+    if (settings.value("notifications/emphasiseApp", true).toBool()) {
+        coverWidget->move(0, 0);
+        coverWidget->resize(this->width(), this->height() - 1);
+        coverWidget->clearMask();
+        coverWidget->setVisible(true);
+        QPointer<NotificationObject> shownNotification = notification;
+        QTimer::singleShot(1000, this, [=] {
+            if (closing || notification != shownNotification) return;
+
+            tVariantAnimation* anim = new tVariantAnimation(this);
+            QPoint origin = ui->appIcon->geometry().center();
+
+            int radius = qSqrt(qPow(this->width() - origin.x(), 2) + qPow(this->height() - origin.y(), 2));
+            anim->setStartValue(radius);
+            anim->setEndValue(1);
+            anim->setDuration(250);
+            anim->setEasingCurve(QEasingCurve::InCubic);
+            connect(anim, &tVariantAnimation::valueChanged, [=](QVariant value) {
+                QRegion r(QRect(origin.x() - value.toInt(), origin.y() - value.toInt(), value.toInt() * 2, value.toInt() * 2), QRegion::Ellipse);
+                coverWidget->setMask(r);
+                this->repaint();
+                ui->mainWidget->repaint();
             });
-        } else {
-            dismisser->start();
-        }
+            connect(anim, &tVariantAnimation::finished, [=] {
+                coverWidget->setVisible(false);
+                anim->deleteLater();
+            });
+            anim->start();
 
-        mouseEvents = true;
+            dismisser->start();
+        });
+    } else {
+        dismisser->start();
     }
+
+    mouseEvents = true;
 }
 
 void NotificationPopup::close() {
+    if (closing) return;
+    closing = true;
     dismisser->stop();
 
     QRect screenGeometry = QApplication::screens().first()->geometry();
@@ -166,11 +246,8 @@ void NotificationPopup::close() {
     connect(anim, SIGNAL(finished()), anim, SLOT(deleteLater()));
     connect(anim, &tPropertyAnimation::finished, [=] {
         QDialog::close();
-        currentlyShowingPopup = nullptr;
-
-        if (pendingPopups.count() > 0) {
-            pendingPopups.takeFirst()->show();
-        }
+        coverWidget->setVisible(false);
+        showNextNotification();
     });
     anim->start();
 
@@ -223,7 +300,8 @@ void NotificationPopup::leaveEvent(QEvent *event) {
     Q_UNUSED(event)
 
     if (mouseEvents) {
-        if (!this->rect().contains(mapFromGlobal(QCursor::pos()))) {
+        //Don't pull the reply box away while the user is typing into it
+        if (!this->rect().contains(mapFromGlobal(QCursor::pos())) && !ui->replyBox->hasFocus()) {
             tVariantAnimation* anim = new tVariantAnimation();
             anim->setStartValue(ui->buttonsWidget->height());
             anim->setEndValue(0);
@@ -388,9 +466,23 @@ void NotificationPopup::setHints(QVariantMap hints) {
     } else {
         this->urgency = 1;
     }
+
+    bool showProgress = hints.contains("value");
+    if (showProgress) ui->progressBar->setValue(qBound(0, hints.value("value").toInt(), 100));
+    if (ui->progressBar->isVisible() != showProgress) {
+        ui->progressBar->setVisible(showProgress);
+        if (this->isVisible()) this->setFixedHeight(ui->mainWidget->sizeHint().height());
+    }
+
+    ui->replyBox->setPlaceholderText(hints.value("x-kde-reply-placeholder-text", tr("Reply")).toString());
 }
 
 void NotificationPopup::setActions(QStringList actions, bool actionNamesAreIcons) {
+    //Progress updates resend the same actions, so keep the buttons (and anything typed into the reply box)
+    if (actions == actionList) return;
+    actionList = actions;
+    ui->replyWidget->setVisible(false);
+
     QBoxLayout* layout = (QBoxLayout*) ui->actionsWidget->layout();
 
     QLayoutItem* item = layout->takeAt(0);
@@ -400,12 +492,20 @@ void NotificationPopup::setActions(QStringList actions, bool actionNamesAreIcons
 
         item = layout->takeAt(0);
     }
+    this->actions.clear();
 
     if (actions.count() % 2 == 0) {
         for (int i = 0; i < actions.length(); i += 2) {
             QString key = actions.at(i);
             QString value = actions.at(i + 1);
 
+            if (key == "inline-reply") {
+                //Shown as a text box instead of a button
+                ui->sendReplyButton->setText(value.isEmpty() ? tr("Reply") : value);
+                ui->replyWidget->setVisible(true);
+                continue;
+            }
+
             QPushButton* button = new QPushButton();
             button->setText(value);
 
@@ -558,3 +658,13 @@ void NotificationPopup::on_timeoutButton_clicked()
     stopDismisser();
     this->close();
 }
+
+void NotificationPopup::on_sendReplyButton_clicked()
+{
+    QString text = ui->replyBox->text();
+    if (text.isEmpty()) return;
+
+    emit replied(text);
+    ui->replyBox->clear();
+    this->close();
+}
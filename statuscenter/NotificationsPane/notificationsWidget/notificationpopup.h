@@ -34,6 +34,9 @@
 #include <QBoxLayout>
 #include <QDirIterator>
 #include <QtMath>
+#include <QPointer>
+
+class NotificationObject;
 
 namespace Ui {
 class NotificationPopup;
@@ -44,10 +47,11 @@ class NotificationPopup : public QDialog
     Q_OBJECT
 
 public:
-    explicit NotificationPopup(int id, QWidget *parent = nullptr);
     ~NotificationPopup();
 
-    void show();
+    static void showNotification(NotificationObject* notification);
+    static void hideNotification(NotificationObject* notification);
+
     void close();
 
     void setApp(QString appName, QIcon appIcon);
@@ -65,16 +69,25 @@ private slots:
 
     void on_timeoutButton_clicked();
 
+    void on_sendReplyButton_clicked();
+
     signals:
     void actionClicked(QString key);
+    void replied(QString text);
     void notificationClosed(uint reason);
 
 private:
+    explicit NotificationPopup(QWidget *parent = nullptr);
     Ui::NotificationPopup *ui;
 
-    int id;
+    void show();
+    void setNotification(NotificationObject* notification);
+    static void showNextNotification();
+
+    QPointer<NotificationObject> notification;
     int textHeight;
     bool mouseEvents = false;
+    bool closing = false;
 
     void enterEvent(QEvent* event);
     void leaveEvent(QEvent* event);
@@ -85,11 +98,13 @@ private:
     QTimer* dismisser = nullptr;
     int timeoutLeft;
     QMap<QString, QString> actions;
+    QStringList actionList;
     QVariantMap hints;
     int urgency = 0;
 
-    static NotificationPopup* currentlyShowingPopup;
-    static QList<NotificationPopup*> pendingPopups;
+    //One popup surface is shared by every notification and only exists while there is something to show
+    static NotificationPopup* popup;
+    static QList<QPointer<NotificationObject>> pendingNotifications;
 
     QWidget* coverWidget;
     QLabel *coverAppIcon, *coverAppName;
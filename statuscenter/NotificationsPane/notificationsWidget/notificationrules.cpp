@@ -0,0 +1,126 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#include "notificationrules.h"
+
+#include <QSettings>
+
+struct NotificationRulesPrivate {
+    NotificationRules* instance = nullptr;
+    QList<NotificationRule> rules;
+};
+
+NotificationRulesPrivate* NotificationRules::d = new NotificationRulesPrivate();
+
+NotificationRules::NotificationRules(QObject *parent) : QObject(parent)
+{
+    QSettings settings;
+    int count = settings.beginReadArray("notifications/rules");
+    for (int i = 0; i < count; i++) {
+        settings.setArrayIndex(i);
+
+        NotificationRule rule;
+        rule.name = settings.value("name").toString();
+        rule.app = settings.value("app").toString();
+        rule.summaryPattern = settings.value("summary").toString();
+        rule.bodyPattern = settings.value("body").toString();
+        rule.category = settings.value("category").toString();
+        rule.urgency = settings.value("urgency", -1).toInt();
+        rule.bypassQuietMode = settings.value("bypassQuiet", false).toBool();
+        rule.silence = settings.value("silence", false).toBool();
+        rule.suppressPopup = settings.value("suppressPopup", false).toBool();
+        rule.sound = settings.value("sound").toString();
+        rule.dismissAfter = settings.value("dismissAfter", 0).toInt();
+
+        //A rule that no longer compiles would match things it shouldn't, so it's flagged and skipped when matching
+        compile(rule);
+        d->rules.append(rule);
+    }
+    settings.endArray();
+}
+
+NotificationRules* NotificationRules::instance() {
+    if (d->instance == nullptr) d->instance = new NotificationRules();
+    return d->instance;
+}
+
+QList<NotificationRule> NotificationRules::rules() {
+    return d->rules;
+}
+
+void NotificationRules::setRules(QList<NotificationRule> rules) {
+    QSettings settings;
+    settings.remove("notifications/rules");
+    settings.beginWriteArray("notifications/rules", rules.count());
+    d->rules.clear();
+    for (int i = 0; i < rules.count(); i++) {
+        NotificationRule rule = rules.at(i);
+        settings.setArrayIndex(i);
+        settings.setValue("name", rule.name);
+        settings.setValue("app", rule.app);
+        settings.setValue("summary", rule.summaryPattern);
+        settings.setValue("body", rule.bodyPattern);
+        settings.setValue("category", rule.category);
+        settings.setValue("urgency", rule.urgency);
+        settings.setValue("bypassQuiet", rule.bypassQuietMode);
+        settings.setValue("silence", rule.silence);
+        settings.setValue("suppressPopup", rule.suppressPopup);
+        settings.setValue("sound", rule.sound);
+        settings.setValue("dismissAfter", rule.dismissAfter);
+
+        compile(rule);
+        d->rules.append(rule);
+    }
+    settings.endArray();
+
+    emit rulesChanged();
+}
+
+bool NotificationRules::compile(NotificationRule& rule) {
+    rule.summaryExpression = QRegularExpression(rule.summaryPattern, QRegularExpression::CaseInsensitiveOption);
+    rule.bodyExpression = QRegularExpression(rule.bodyPattern, QRegularExpression::CaseInsensitiveOption);
+    rule.valid = rule.summaryExpression.isValid() && rule.bodyExpression.isValid();
+    if (!rule.valid) return false;
+
+    //Rules run against every notification, so pay for JIT compilation up front
+    rule.summaryExpression.optimize();
+    rule.bodyExpression.optimize();
+    return true;
+}
+
+bool NotificationRules::match(const QString &appName, const QString &summary, const QString &body, const QVariantMap &hints, NotificationRule& rule) {
+    int urgency = hints.value("urgency", 1).toInt();
+    QString category = hints.value("category").toString();
+    QString desktopEntry = hints.value("desktop-entry").toString();
+
+    //The first matching rule wins
+    for (const NotificationRule& candidate : d->rules) {
+        if (!candidate.valid) continue;
+        if (!candidate.app.isEmpty() && candidate.app.compare(appName, Qt::CaseInsensitive) != 0 && candidate.app != desktopEntry) continue;
+        if (candidate.urgency != -1 && candidate.urgency != urgency) continue;
+        if (!candidate.category.isEmpty() && candidate.category != category) continue;
+        if (!candidate.summaryPattern.isEmpty() && !candidate.summaryExpression.match(summary).hasMatch()) continue;
+        if (!candidate.bodyPattern.isEmpty() && !candidate.bodyExpression.match(body).hasMatch()) continue;
+
+        rule = candidate;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef NOTIFICATIONRULES_H
+#define NOTIFICATIONRULES_H
+
+#include <QObject>
+#include <QRegularExpression>
+#include <QVariantMap>
+#include <debuginformationcollector.h>
+
+struct NotificationRule {
+    QString name;
+
+    //Conditions; anything left empty matches every notification
+    QString app;
+    QString summaryPattern;
+    QString bodyPattern;
+    QString category;
+    int urgency = -1;
+
+    //Actions
+    bool bypassQuietMode = false;
+    bool silence = false;
+    bool suppressPopup = false;
+    QString sound;
+    int dismissAfter = 0;
+
+    //Compiled from the patterns when the rules are loaded
+    //Rules whose patterns don't compile are kept so they aren't lost on the next save, but never match
+    QRegularExpression summaryExpression;
+    QRegularExpression bodyExpression;
+    bool valid = true;
+};
+
+struct NotificationRulesPrivate;
+class NotificationRules : public QObject
+{
+        Q_OBJECT
+    public:
+        static NotificationRules* instance();
+
+        QList<NotificationRule> rules();
+        void setRules(QList<NotificationRule> rules);
+
+        bool match(const QString &appName, const QString &summary, const QString &body, const QVariantMap &hints, NotificationRule& rule);
+
+        static bool compile(NotificationRule& rule);
+
+    signals:
+        void rulesChanged();
+
+    private:
+        explicit NotificationRules(QObject *parent = T_QOBJECT_ROOT);
+        static NotificationRulesPrivate* d;
+};
+
+#endif // NOTIFICATIONRULES_H
@@ -24,13 +24,38 @@
 #include "audiomanager.h"
 
 #include "notificationspermissionengine.h"
+#include "notificationrules.h"
 #include <quietmodedaemon.h>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 
 NotificationsDBusAdaptor::NotificationsDBusAdaptor(QObject *parent, ApplicationNotificationModel* appModel)
     : QDBusAbstractAdaptor(parent)
 {
     this->setAutoRelaySignals(true);
     this->appModel = appModel;
+
+    floodTimer = new QTimer(this);
+    floodTimer->setInterval(1000);
+    floodTimer->setSingleShot(true);
+    connect(floodTimer, &QTimer::timeout, this, &NotificationsDBusAdaptor::postFloodSummaries);
+
+    //Keep track of the lock screen here so Notify never has to ask for it
+    lockScreenWatcher = new QDBusServiceWatcher("org.thesuite.tsscreenlock", QDBusConnection::sessionBus(), QDBusServiceWatcher::WatchForRegistration | QDBusServiceWatcher::WatchForUnregistration, this);
+    connect(lockScreenWatcher, &QDBusServiceWatcher::serviceRegistered, this, [=] {
+        setScreenLocked(true);
+    });
+    connect(lockScreenWatcher, &QDBusServiceWatcher::serviceUnregistered, this, [=] {
+        setScreenLocked(false);
+    });
+
+    QDBusPendingCallWatcher* lockedWatcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().interface()->asyncCall("NameHasOwner", "org.thesuite.tsscreenlock"), this);
+    connect(lockedWatcher, &QDBusPendingCallWatcher::finished, this, [=] {
+        QDBusPendingReply<bool> reply = *lockedWatcher;
+        if (!reply.isError()) setScreenLocked(reply.value());
+        lockedWatcher->deleteLater();
+    });
 }
 
 NotificationsDBusAdaptor::~NotificationsDBusAdaptor()
@@ -50,7 +75,7 @@ void NotificationsDBusAdaptor::CloseNotification(uint id)
 
 QStringList NotificationsDBusAdaptor::GetCapabilities()
 {
-    return QStringList() << "body" << "body-hyperlinks" << "body-markup" << "persistence" << "sound" << "action-icons";
+    return QStringList() << "body" << "body-hyperlinks" << "body-markup" << "persistence" << "sound" << "action-icons" << "inline-reply";
 }
 
 QString NotificationsDBusAdaptor::GetServerInformation(QString &vendor, QString &version, QString &spec_version)
@@ -64,8 +89,16 @@ QString NotificationsDBusAdaptor::GetServerInformation(QString &vendor, QString
 uint NotificationsDBusAdaptor::Notify(const QString &app_name, uint replaces_id, const QString &app_icon, const QString &summary, const QString &body, const QStringList &actions, const QVariantMap &hints, int expire_timeout)
 {
     if (this->parentWidget() != nullptr) {
+        if (!this->parentWidget()->hasNotificationId(replaces_id)) {
+            //Fold this notification into a summary if the sender is flooding us
+            //This comes first so that a flood costs as little as possible
+            uint summaryId = checkFlood(app_name, hints);
+            if (summaryId != 0) return summaryId;
+        }
+
         QStringList knownApplications;
         NotificationsPermissionEngine permissions(app_name, hints.value("desktop-entry", "").toString());
+        appModel->addApplication(permissions);
 
         if (!permissions.allowNotifications()) {
             //User doesn't want this app to post notifications
@@ -73,24 +106,39 @@ uint NotificationsDBusAdaptor::Notify(const QString &app_name, uint replaces_id,
             return 999999;
         }
 
+        //The user's rules can change how this notification is delivered
+        NotificationRule rule;
+        bool ruleMatched = NotificationRules::instance()->match(app_name, summary, body, hints, rule);
+        QVariantMap notificationHints = hints;
+        if (ruleMatched) {
+            if (rule.silence) notificationHints.insert("suppress-sound", true);
+            if (!rule.sound.isEmpty()) notificationHints.insert("sound-file", rule.sound);
+        }
+        bool bypassesQuietMode = permissions.bypassesQuietMode() || (ruleMatched && rule.bypassQuietMode);
+
         NotificationObject* notification;
+        bool progressUpdate = false;
         if (this->parentWidget()->hasNotificationId(replaces_id)) {
             notification = this->parentWidget()->getNotification(replaces_id);
+
+            //Progress updates refresh the notification in place instead of announcing it again
+            progressUpdate = notification->getHints().contains("value") && notificationHints.contains("value");
+
             QString name = app_name;
             QString icon = app_icon;
             QString sum = summary;
             QString bod = body;
             QStringList ac = actions;
-            QVariantMap h = hints;
+            QVariantMap h = notificationHints;
             int expire = expire_timeout;
             notification->setParameters(name, icon, sum, bod, ac, h, expire);
         } else {
-            notification = new NotificationObject(app_name, app_icon, summary, body, actions, hints, expire_timeout);
+            notification = new NotificationObject(app_name, app_icon, summary, body, actions, notificationHints, expire_timeout);
             this->parentWidget()->addNotification(notification);
         }
 
         bool postNotification = true;
-        if (QuietModeDaemon::getQuietMode() == QuietModeDaemon::Notifications && !permissions.bypassesQuietMode()) {
+        if (QuietModeDaemon::getQuietMode() == QuietModeDaemon::Notifications && !bypassesQuietMode) {
             QStringList allowedCategories;
             allowedCategories.append("battery.low");
             allowedCategories.append("battery.critical");
@@ -99,7 +147,7 @@ uint NotificationsDBusAdaptor::Notify(const QString &app_name, uint replaces_id,
                 postNotification = false;
                 emit NotificationClosed(notification->getId(), NotificationObject::Undefined);
             }
-        } else if (QuietModeDaemon::getQuietMode() == QuietModeDaemon::Critical && !permissions.bypassesQuietMode()) {
+        } else if (QuietModeDaemon::getQuietMode() == QuietModeDaemon::Critical && !bypassesQuietMode) {
             if (hints.value("urgency", 1).toInt() != 2) {
                 postNotification = false;
                 emit NotificationClosed(notification->getId(), NotificationObject::Undefined);
@@ -109,42 +157,168 @@ uint NotificationsDBusAdaptor::Notify(const QString &app_name, uint replaces_id,
             emit NotificationClosed(notification->getId(), NotificationObject::Undefined);
         }
 
-        if (postNotification) {
-            notification->post();
-            appModel->loadData();
+        if (postNotification && !progressUpdate) {
+            //Notifications with their popup suppressed still go to the notification pane
+            bool showPopup = !(ruleMatched && rule.suppressPopup);
+
+            //Don't put the contents of a notification on screen while the screen is locked unless the user allows it
+            if (screenLocked && settings.value("notifications/lockScreen", "noContents").toString() != "contents") showPopup = false;
+
+            notification->post(showPopup);
         }
 
-        //Send the notification to the lock screen if the user desires
-        if (settings.value("notifications/lockScreen").toString() != "none") {
-            //If the notification is transient, don't send it to the lock screen
-            if (!hints.value("transient", false).toBool()) {
-                //Create a DBus message relaying the message to the lock screen
-                QDBusMessage NotificationEmit = QDBusMessage::createMethodCall("org.thesuite.tsscreenlock", "/org/thesuite/tsscreenlock", "org.thesuite.tsscreenlock.Notifications", "newNotification");
-                QVariantList NotificationArgs;
-
-                if (settings.value("notifications/lockScreen", "noContents").toString() == "contents") {
-                    NotificationArgs.append(summary);
-                    NotificationArgs.append(body);
-                    NotificationArgs.append(notification->getId());
-                    NotificationArgs.append(actions);
-                } else {
-                    NotificationArgs.append(app_name);
-                    NotificationArgs.append("New Notification");
-                    NotificationArgs.append(notification->getId());
-                    NotificationArgs.append(QStringList());
-                }
-                NotificationArgs.append(hints);
-
-                NotificationEmit.setArguments(NotificationArgs);
-                QDBusConnection::sessionBus().call(NotificationEmit, QDBus::NoBlock);
+        //One timer per notification, so replacing a notification pushes its dismissal back instead of adding another
+        QTimer* dismissTimer = notification->findChild<QTimer*>("dismissAfter", Qt::FindDirectChildrenOnly);
+        if (ruleMatched && rule.dismissAfter > 0) {
+            if (dismissTimer == nullptr) {
+                dismissTimer = new QTimer(notification);
+                dismissTimer->setObjectName("dismissAfter");
+                dismissTimer->setSingleShot(true);
+                connect(dismissTimer, &QTimer::timeout, notification, &NotificationObject::dismiss);
             }
+            dismissTimer->start(rule.dismissAfter * 1000);
+        } else if (dismissTimer != nullptr) {
+            //The replacement no longer matches a rule that dismisses it
+            dismissTimer->stop();
         }
 
+        //Send the notification to the lock screen if the user desires
+        if (screenLocked && !progressUpdate) relayToLockScreen(notification, app_name, summary, body, actions, hints);
+
         return notification->getId();
     }
     return 0;
 }
 
+uint NotificationsDBusAdaptor::checkFlood(const QString &app_name, const QVariantMap &hints) {
+    //Buckets are per sender so one app can't use up another's allowance
+    QString sender;
+    NotificationsDBusObject* object = qobject_cast<NotificationsDBusObject*>(this->parent());
+    if (object != nullptr && object->calledFromDBus()) sender = object->message().service();
+
+    int burst = settings.value("notifications/floodBurst", 10).toInt();
+    double rate = settings.value("notifications/floodRate", 2).toDouble();
+
+    NotificationFloodBucket& bucket = floodBuckets[app_name + "\n" + sender];
+    if (!bucket.lastRefill.isValid()) {
+        bucket.tokens = burst;
+        bucket.lastRefill.start();
+    } else {
+        bucket.tokens = qMin<double>(burst, bucket.tokens + bucket.lastRefill.restart() * rate / 1000);
+    }
+
+    if (bucket.tokens >= 1) {
+        bucket.tokens -= 1;
+
+        //Let the timer clear out senders we haven't heard from in a while
+        if (floodBuckets.count() > 64 && !floodTimer->isActive()) floodTimer->start();
+        return 0;
+    }
+
+    //Over the limit, so don't run the rest of the pipeline; the summary is posted on the next timer tick
+    if (bucket.summary.isNull()) {
+        //Suppressed notifications skip the permission check, so make sure the app may post before there's a summary to post
+        NotificationsPermissionEngine permissions(app_name, hints.value("desktop-entry", "").toString());
+        if (!permissions.allowNotifications()) {
+            emit NotificationClosed(999999, 2);
+            return 999999;
+        }
+
+        bucket.suppressed = 0;
+        bucket.summary = new NotificationObject(app_name, "", "", "", QStringList(), QVariantMap(), -1);
+    }
+    bucket.suppressed++;
+    bucket.summaryPending = true;
+    bucket.hints = hints;
+    if (!floodTimer->isActive()) floodTimer->start();
+
+    return bucket.summary->getId();
+}
+
+void NotificationsDBusAdaptor::postFloodSummaries() {
+    for (auto i = floodBuckets.begin(); i != floodBuckets.end();) {
+        NotificationFloodBucket& bucket = i.value();
+        if (bucket.summaryPending && !bucket.summary.isNull()) {
+            bucket.summaryPending = false;
+
+            //The app may have been blocked since the summary was started
+            NotificationsPermissionEngine permissions(bucket.summary->getAppName(), bucket.hints.value("desktop-entry", "").toString());
+            if (!permissions.allowNotifications()) {
+                //Drop the summary so the next flood starts over instead of returning its id
+                if (!this->parentWidget()->hasNotificationId(bucket.summary->getId())) bucket.summary->deleteLater();
+                bucket.summary = nullptr;
+                bucket.suppressed = 0;
+                i++;
+                continue;
+            }
+
+            QString name = bucket.summary->getAppName();
+            QString icon = bucket.summary->getAppIconName();
+            QString summary = tr("%1 sent %n notifications", nullptr, bucket.suppressed).arg(name);
+            QString body = tr("These notifications arrived too quickly to show individually.");
+            QStringList actions;
+
+            QVariantMap hints;
+            hints.insert("suppress-sound", true);
+            if (bucket.hints.contains("desktop-entry")) hints.insert("desktop-entry", bucket.hints.value("desktop-entry"));
+            bucket.summary->setParameters(name, icon, summary, body, actions, hints, -1);
+
+            if (!this->parentWidget()->hasNotificationId(bucket.summary->getId())) {
+                this->parentWidget()->addNotification(bucket.summary);
+            }
+            if (QuietModeDaemon::getQuietMode() == QuietModeDaemon::None) {
+                bucket.summary->post();
+            }
+        }
+
+        //Forget senders that have calmed down
+        if (!bucket.summaryPending && bucket.lastRefill.elapsed() > 60000) {
+            i = floodBuckets.erase(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void NotificationsDBusAdaptor::setScreenLocked(bool locked) {
+    screenLocked = locked;
+}
+
+void NotificationsDBusAdaptor::relayToLockScreen(NotificationObject* notification, const QString &app_name, const QString &summary, const QString &body, const QStringList &actions, const QVariantMap &hints) {
+    QString privacy = settings.value("notifications/lockScreen", "noContents").toString();
+    if (privacy == "none") return;
+
+    //If the notification is transient, don't send it to the lock screen
+    if (hints.value("transient", false).toBool()) return;
+
+    //Create a DBus message relaying the message to the lock screen
+    QDBusMessage NotificationEmit = QDBusMessage::createMethodCall("org.thesuite.tsscreenlock", "/org/thesuite/tsscreenlock", "org.thesuite.tsscreenlock.Notifications", "newNotification");
+    QVariantList NotificationArgs;
+
+    if (privacy == "contents") {
+        NotificationArgs.append(summary);
+        NotificationArgs.append(body);
+        NotificationArgs.append(notification->getId());
+        NotificationArgs.append(actions);
+        NotificationArgs.append(hints);
+    } else {
+        NotificationArgs.append(app_name);
+        NotificationArgs.append(tr("New Notification"));
+        NotificationArgs.append(notification->getId());
+        NotificationArgs.append(QStringList());
+
+        //Hints can carry contents too (images, progress, sound names), so only pass along the ones that say how to present it
+        QVariantMap safeHints;
+        for (QString hint : {"urgency", "category", "desktop-entry", "suppress-sound"}) {
+            if (hints.contains(hint)) safeHints.insert(hint, hints.value(hint));
+        }
+        NotificationArgs.append(safeHints);
+    }
+
+    NotificationEmit.setArguments(NotificationArgs);
+    QDBusConnection::sessionBus().asyncCall(NotificationEmit);
+}
+
 NotificationsWidget* NotificationsDBusAdaptor::parentWidget() {
     return pt;
 }
@@ -32,10 +32,35 @@
 #include <QApplication>
 #include <QDBusReply>
 #include <QSettings>
+#include <QDBusContext>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QDBusServiceWatcher>
 #include "settings/applicationnotificationmodel.h"
 #include "audiomanager.h"
 
 class NotificationsWidget;
+class NotificationObject;
+
+//Registered on the bus in place of a plain QObject so the adaptor can see who is calling
+class NotificationsDBusObject : public QObject, public QDBusContext
+{
+    Q_OBJECT
+public:
+    explicit NotificationsDBusObject(QObject* parent = nullptr) : QObject(parent) {}
+};
+
+struct NotificationFloodBucket {
+    double tokens = 0;
+    QElapsedTimer lastRefill;
+
+    //Notifications folded into the summary since it was posted
+    int suppressed = 0;
+    bool summaryPending = false;
+    QPointer<NotificationObject> summary;
+    QVariantMap hints;
+};
 
 class NotificationsDBusAdaptor : public QDBusAbstractAdaptor
 {
@@ -51,6 +76,10 @@ class NotificationsDBusAdaptor : public QDBusAbstractAdaptor
 "      <arg direction=\"out\" type=\"u\" name=\"id\"/>\n"
 "      <arg direction=\"out\" type=\"s\" name=\"action_key\"/>\n"
 "    </signal>\n"
+"    <signal name=\"NotificationReplied\">\n"
+"      <arg direction=\"out\" type=\"u\" name=\"id\"/>\n"
+"      <arg direction=\"out\" type=\"s\" name=\"text\"/>\n"
+"    </signal>\n"
 "    <method name=\"GetCapabilities\">\n"
 "      <arg direction=\"out\" type=\"as\"/>\n"
 "    </method>\n"
@@ -95,11 +124,25 @@ public slots: // METHODS
 signals: // SIGNALS
     void ActionInvoked(uint id, const QString &action_key);
     void NotificationClosed(uint id, uint reason);
+    void NotificationReplied(uint id, const QString &text);
+
+private slots:
+    void postFloodSummaries();
+    void setScreenLocked(bool locked);
 
 private:
     NotificationsWidget* pt = NULL;
     ApplicationNotificationModel* appModel;
     QSettings settings;
+
+    uint checkFlood(const QString &app_name, const QVariantMap &hints);
+    QHash<QString, NotificationFloodBucket> floodBuckets;
+    QTimer* floodTimer;
+
+    //The lock screen owns its bus name only while it is showing
+    QDBusServiceWatcher* lockScreenWatcher;
+    bool screenLocked = false;
+    void relayToLockScreen(NotificationObject* notification, const QString &app_name, const QString &summary, const QString &body, const QStringList &actions, const QVariantMap &hints);
 };
 
 struct ImageData {
@@ -20,11 +20,13 @@
 
 #include "notificationswidget.h"
 #include "ui_notificationswidget.h"
+#include "notificationhistory.h"
 
 #include <QScroller>
 #include <QDBusConnectionInterface>
 #include "kjob/jobviewwidget.h"
 #include <mpris/mprisengine.h>
+#include <mpris/mprishub.h>
 #include <quietmodedaemon.h>
 
 NotificationsWidget::NotificationsWidget(QWidget *parent) :
@@ -45,6 +47,13 @@ NotificationsWidget::NotificationsWidget(QWidget *parent) :
         Q_UNUSED(service)
         addMediaPlayer(player);
     });
+    connect(MprisHub::instance(), &MprisHub::currentPlayerChanged, this, [=](MprisPlayerPtr player) {
+        //Keep the player that media keys control at the top
+        if (!mediaPlayers.contains(player)) return;
+        MediaPlayerNotification* n = mediaPlayers.value(player);
+        ui->notificationGroups->layout()->removeWidget(n);
+        ((QBoxLayout*) ui->notificationGroups->layout())->insertWidget(0, n);
+    });
 
     connect(QuietModeDaemon::instance(), &QuietModeDaemon::QuietModeChanged, [=](QuietModeDaemon::QuietMode newMode) {
         ui->quietModeSound->setChecked(false);
@@ -87,8 +96,19 @@ NotificationsWidget::NotificationsWidget(QWidget *parent) :
     snack->setVisible(false);
     snack->setText("0");
 
+    connect(NotificationHistory::instance(), &NotificationHistory::loaded, this, [=](QList<NotificationHistory::Entry> entries) {
+        for (NotificationHistory::Entry entry : entries) {
+            //Actions can't be restored because whoever would handle them is gone
+            NotificationObject* object = new NotificationObject(entry.appName, entry.appIcon, entry.summary, entry.body, QStringList(), entry.hints, -1);
+            object->setDate(entry.date);
+            NotificationHistory::instance()->add(object, entry.key);
+            addNotification(object);
+        }
+    });
+
     QTimer::singleShot(0, [=] {
         ui->quietModeDescription->setText(QuietModeDaemon::getCurrentQuietModeDescription());
+        NotificationHistory::instance()->load();
 
         sendMessage("register-chunk", {QVariant::fromValue(chunk)});
         sendMessage("register-snack", {QVariant::fromValue(snack)});
@@ -149,9 +169,18 @@ void NotificationsWidget::addNotification(NotificationObject *object) {
         emit adaptor->ActionInvoked(object->getId(), key);
         object->dismiss();
     });
+    connect(object, &NotificationObject::replied, object, [=](QString text) {
+        emit adaptor->NotificationReplied(object->getId(), text);
+        object->dismiss();
+    });
+    connect(object, &NotificationObject::parametersUpdated, this, [=] {
+        NotificationHistory::instance()->update(object);
+    });
     connect(object, &NotificationObject::closed, object, [=](NotificationObject::NotificationCloseReason reason) {
         emit adaptor->NotificationClosed(object->getId(), reason);
         notifications.remove(object->getId());
+        NotificationHistory::instance()->remove(object);
+        object->deleteLater();
 
         if (notifications.count() == 0 && mediaPlayers.count() == 0) {
             ui->noNotificationsFrame->setVisible(true);
@@ -160,29 +189,33 @@ void NotificationsWidget::addNotification(NotificationObject *object) {
         updateNotificationsNumber();
     });
 
-    NotificationAppGroup* nGroup = nullptr;
+    QString identifier = object->getAppIdentifier();
+    NotificationAppGroup* nGroup = notificationGroups.value(identifier);
 
-    for (NotificationAppGroup* group : notificationGroups) {
-        if (group->getIdentifier() == object->getAppIdentifier()) {
-            nGroup = group;
-            break;
-        }
-    }
-
-    if (nGroup == nullptr) {
-        nGroup = new NotificationAppGroup(object->getAppIdentifier(), object->getAppIcon(), object->getAppName());
+    //An empty group is already animating away, so start a fresh one
+    if (nGroup == nullptr || nGroup->count() == 0) {
+        nGroup = new NotificationAppGroup(identifier, object->getAppIcon(), object->getAppName());
         ((QBoxLayout*) ui->notificationGroups->layout())->insertWidget(mediaPlayers.count(), nGroup);
 
         connect(nGroup, SIGNAL(notificationCountChanged()), this, SLOT(updateNotificationCount()));
-        connect(nGroup, &NotificationAppGroup::destroyed, [=] {
+        connect(nGroup, &NotificationAppGroup::destroyed, this, [=] {
             ui->notificationGroups->layout()->removeWidget(nGroup);
-            notificationGroups.removeOne(nGroup);
+            if (notificationGroups.value(identifier) == nGroup) notificationGroups.remove(identifier);
         });
 
-        notificationGroups.append(nGroup);
+        notificationGroups.insert(identifier, nGroup);
     }
 
     nGroup->AddNotification(object);
+    if (!ui->searchBox->text().isEmpty()) nGroup->setFilter(ui->searchBox->text());
+
+    //Keep the history within the limits the user has set
+    NotificationHistory::instance()->add(object);
+    //The user didn't dismiss these, so the sender hears that they expired
+    for (NotificationObject* old : NotificationHistory::instance()->overflow()) {
+        old->close(NotificationObject::Expired);
+    }
+
     updateNotificationsNumber();
 }
 
@@ -229,14 +262,19 @@ void NotificationsWidget::on_clearAllButton_clicked()
     }
 }
 
-void NotificationsWidget::updateNotificationCount() {
-    int count = 0;
-
+void NotificationsWidget::on_searchBox_textChanged(const QString &text)
+{
+    int matches = 0;
     for (NotificationAppGroup* group : notificationGroups) {
-        count += group->count();
+        matches += group->setFilter(text);
     }
 
-    emit numNotificationsChanged(count);
+    ui->noNotificationsFrame->setVisible((!text.isEmpty() && matches == 0) || (notifications.count() == 0 && mediaPlayers.count() == 0));
+}
+
+void NotificationsWidget::updateNotificationCount() {
+    //Every notification has exactly one panel, so there's no need to ask each group
+    emit numNotificationsChanged(notifications.count());
 }
 
 
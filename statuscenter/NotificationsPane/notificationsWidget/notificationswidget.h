@@ -88,6 +88,8 @@ private slots:
 
     void updateNotificationsNumber();
 
+    void on_searchBox_textChanged(const QString &text);
+
 signals:
     void numNotificationsChanged(int number);
 
@@ -99,8 +101,8 @@ private:
 
     void addMediaPlayer(MprisPlayerPtr player);
 
-    QMap<int, NotificationObject*> notifications;
-    QList<NotificationAppGroup*> notificationGroups;
+    QHash<uint, NotificationObject*> notifications;
+    QHash<QString, NotificationAppGroup*> notificationGroups;
     QMap<MprisPlayerPtr, MediaPlayerNotification*> mediaPlayers;
 
     QLabel *chunk, *snack;
@@ -38,7 +38,7 @@ Plugin::Plugin(QObject *parent) :
 
     panes.append(AudioManager::instance());
 
-    QObject* notificationParent = new QObject();
+    NotificationsDBusObject* notificationParent = new NotificationsDBusObject();
     NotificationsDBusAdaptor* adaptor = new NotificationsDBusAdaptor(notificationParent, settings->appModel());
 
     QDBusConnection::sessionBus().registerObject("/org/freedesktop/Notifications", "org.freedesktop.Notifications", notificationParent);
@@ -24,8 +24,29 @@
 
 struct ApplicationNotificationModelPrivate {
     QList<ApplicationInformation> appInformation;
+    QSet<QString> knownApps;
+
+    static ApplicationInformation information(NotificationsPermissionEngine& permissions);
+    int row(QString key);
 };
 
+ApplicationInformation ApplicationNotificationModelPrivate::information(NotificationsPermissionEngine& permissions) {
+    ApplicationInformation info;
+    if (permissions.isDesktopFile()) info.desktopEntry = permissions.identifier();
+    info.name = permissions.appName();
+    info.icon = permissions.appIcon();
+    info.allowNotifications = permissions.allowNotifications();
+    return info;
+}
+
+int ApplicationNotificationModelPrivate::row(QString key) {
+    if (!knownApps.contains(key)) return -1;
+    for (int i = 0; i < appInformation.count(); i++) {
+        if (appInformation.at(i).key() == key) return i;
+    }
+    return -1;
+}
+
 ApplicationNotificationModel::ApplicationNotificationModel(QObject *parent)
     : QAbstractListModel(parent)
 {
@@ -71,6 +92,9 @@ QVariant ApplicationNotificationModel::data(const QModelIndex &index, int role)
                 return info.name;
             case Qt::DecorationRole:
                 return info.icon;
+            case Qt::ToolTipRole:
+                if (!info.allowNotifications) return tr("Notifications are turned off for %1").arg(info.name);
+                return QVariant();
             case Qt::UserRole:
                 return QVariant::fromValue(info);
         }
@@ -79,29 +103,63 @@ QVariant ApplicationNotificationModel::data(const QModelIndex &index, int role)
 }
 
 void ApplicationNotificationModel::loadData() {
+    beginResetModel();
     d->appInformation.clear();
+    d->knownApps.clear();
     QStringList allDesktopApps = NotificationsPermissionEngine::knownDesktopFiles();
     for (QString app : allDesktopApps) {
         NotificationsPermissionEngine permissions("", app);
 
-        ApplicationInformation info;
-        info.desktopEntry = app;
-        info.name = permissions.appName();
-        info.icon = permissions.appIcon();
+        ApplicationInformation info = d->information(permissions);
         d->appInformation.append(info);
+        d->knownApps.insert(info.key());
     }
 
     QStringList allApps = NotificationsPermissionEngine::knownApps();
     for (QString app : allApps) {
         NotificationsPermissionEngine permissions(app);
 
-        ApplicationInformation info;
-        info.name = permissions.appName();
-        info.icon = info.permissionsEngine()->appIcon();
+        ApplicationInformation info = d->information(permissions);
         d->appInformation.append(info);
+        d->knownApps.insert(info.key());
     }
+    endResetModel();
+}
+
+void ApplicationNotificationModel::addApplication(NotificationsPermissionEngine& permissions) {
+    if (!permissions.isValidApp()) return;
+
+    //This is called for every notification, so bail out early for apps we already have
+    QString key = (permissions.isDesktopFile() ? "dsk-" : "app-") + permissions.identifier();
+    if (d->knownApps.contains(key)) return;
+    if (!permissions.isDesktopFile() && permissions.identifier() == "theShell") return;
+
+    //Row 0 is the General item
+    int row = d->appInformation.count() + 1;
+    beginInsertRows(QModelIndex(), row, row);
+    d->appInformation.append(d->information(permissions));
+    d->knownApps.insert(key);
+    endInsertRows();
+}
+
+void ApplicationNotificationModel::updateApplication(NotificationsPermissionEngine& permissions) {
+    if (!permissions.isValidApp()) return;
+
+    int row = d->row((permissions.isDesktopFile() ? "dsk-" : "app-") + permissions.identifier());
+    if (row == -1) return;
+
+    d->appInformation.replace(row, d->information(permissions));
+    emit dataChanged(index(row + 1), index(row + 1));
+}
+
+void ApplicationNotificationModel::removeApplication(const QModelIndex& index) {
+    if (!index.isValid() || index.row() == 0) return;
 
-    emit dataChanged(index(0), index(rowCount()));
+    int row = index.row() - 1;
+    beginRemoveRows(QModelIndex(), index.row(), index.row());
+    d->knownApps.remove(d->appInformation.at(row).key());
+    d->appInformation.removeAt(row);
+    endRemoveRows();
 }
 
 ApplicationNotificationModelDelegate::ApplicationNotificationModelDelegate(QObject* parent) : QStyledItemDelegate(parent)
@@ -29,6 +29,11 @@ struct ApplicationInformation {
     QString name;
     QString desktopEntry;
     QIcon icon;
+    bool allowNotifications = true;
+
+    QString key() const {
+        return desktopEntry.isEmpty() ? "app-" + name : "dsk-" + desktopEntry;
+    }
 
     QSharedPointer<NotificationsPermissionEngine> permissionsEngine() {
         if (desktopEntry.isEmpty()) {
@@ -56,6 +61,11 @@ class ApplicationNotificationModel : public QAbstractListModel
 
         void loadData();
 
+        //Cheaper than reloading everything when a single app changes
+        void addApplication(NotificationsPermissionEngine& permissions);
+        void updateApplication(NotificationsPermissionEngine& permissions);
+        void removeApplication(const QModelIndex& index);
+
     private:
         ApplicationNotificationModelPrivate* d;
 };
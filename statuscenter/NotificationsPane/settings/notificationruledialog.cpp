@@ -0,0 +1,149 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#include "notificationruledialog.h"
+
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QPushButton>
+
+struct NotificationRuleDialogPrivate {
+    QLineEdit *name, *app, *summary, *body, *category, *sound;
+    QComboBox* urgency;
+    QCheckBox *bypassQuietMode, *silence, *suppressPopup;
+    QSpinBox* dismissAfter;
+    QLabel* error;
+    QDialogButtonBox* buttons;
+};
+
+NotificationRuleDialog::NotificationRuleDialog(NotificationRule rule, QWidget *parent) : QDialog(parent)
+{
+    d = new NotificationRuleDialogPrivate();
+    this->setWindowTitle(tr("Notification Rule"));
+
+    QFormLayout* layout = new QFormLayout();
+    this->setLayout(layout);
+
+    d->name = new QLineEdit(rule.name);
+    layout->addRow(tr("Name"), d->name);
+
+    QLabel* conditions = new QLabel(tr("WHEN A NOTIFICATION MATCHES"));
+    QFont boldFont = conditions->font();
+    boldFont.setBold(true);
+    conditions->setFont(boldFont);
+    layout->addRow(conditions);
+
+    d->app = new QLineEdit(rule.app);
+    d->app->setPlaceholderText(tr("Any application"));
+    layout->addRow(tr("Application"), d->app);
+
+    d->summary = new QLineEdit(rule.summaryPattern);
+    d->summary->setPlaceholderText(tr("Regular expression"));
+    layout->addRow(tr("Summary"), d->summary);
+
+    d->body = new QLineEdit(rule.bodyPattern);
+    d->body->setPlaceholderText(tr("Regular expression"));
+    layout->addRow(tr("Body"), d->body);
+
+    d->urgency = new QComboBox();
+    d->urgency->addItem(tr("Any"), -1);
+    d->urgency->addItem(tr("Low"), 0);
+    d->urgency->addItem(tr("Normal"), 1);
+    d->urgency->addItem(tr("Critical"), 2);
+    d->urgency->setCurrentIndex(d->urgency->findData(rule.urgency));
+    layout->addRow(tr("Urgency"), d->urgency);
+
+    d->category = new QLineEdit(rule.category);
+    d->category->setPlaceholderText(tr("Any category"));
+    layout->addRow(tr("Category"), d->category);
+
+    QLabel* actions = new QLabel(tr("THEN"));
+    actions->setFont(boldFont);
+    layout->addRow(actions);
+
+    d->bypassQuietMode = new QCheckBox(tr("Bypass Quiet Mode"));
+    d->bypassQuietMode->setChecked(rule.bypassQuietMode);
+    layout->addRow(d->bypassQuietMode);
+
+    d->silence = new QCheckBox(tr("Don't play a sound"));
+    d->silence->setChecked(rule.silence);
+    layout->addRow(d->silence);
+
+    d->suppressPopup = new QCheckBox(tr("Only show in the notification pane"));
+    d->suppressPopup->setChecked(rule.suppressPopup);
+    layout->addRow(d->suppressPopup);
+
+    d->sound = new QLineEdit(rule.sound);
+    d->sound->setPlaceholderText(tr("Default sound"));
+    layout->addRow(tr("Sound file"), d->sound);
+
+    d->dismissAfter = new QSpinBox();
+    d->dismissAfter->setRange(0, 86400);
+    d->dismissAfter->setSuffix(tr(" s"));
+    d->dismissAfter->setSpecialValueText(tr("Never"));
+    d->dismissAfter->setValue(rule.dismissAfter);
+    layout->addRow(tr("Dismiss after"), d->dismissAfter);
+
+    d->error = new QLabel();
+    d->error->setVisible(false);
+    layout->addRow(d->error);
+
+    d->buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(d->buttons, &QDialogButtonBox::accepted, this, &NotificationRuleDialog::accept);
+    connect(d->buttons, &QDialogButtonBox::rejected, this, &NotificationRuleDialog::reject);
+    layout->addRow(d->buttons);
+
+    connect(d->summary, &QLineEdit::textChanged, this, &NotificationRuleDialog::validate);
+    connect(d->body, &QLineEdit::textChanged, this, &NotificationRuleDialog::validate);
+    validate();
+}
+
+NotificationRuleDialog::~NotificationRuleDialog() {
+    delete d;
+}
+
+NotificationRule NotificationRuleDialog::rule() {
+    NotificationRule rule;
+    rule.name = d->name->text();
+    rule.app = d->app->text();
+    rule.summaryPattern = d->summary->text();
+    rule.bodyPattern = d->body->text();
+    rule.urgency = d->urgency->currentData().toInt();
+    rule.category = d->category->text();
+    rule.bypassQuietMode = d->bypassQuietMode->isChecked();
+    rule.silence = d->silence->isChecked();
+    rule.suppressPopup = d->suppressPopup->isChecked();
+    rule.sound = d->sound->text();
+    rule.dismissAfter = d->dismissAfter->value();
+    return rule;
+}
+
+void NotificationRuleDialog::validate() {
+    //Don't let a rule be saved if it could never match anything
+    NotificationRule rule = this->rule();
+    bool valid = NotificationRules::compile(rule);
+    d->error->setText(tr("The summary or body pattern isn't a valid regular expression."));
+    d->error->setVisible(!valid);
+    d->buttons->button(QDialogButtonBox::Ok)->setEnabled(valid);
+}
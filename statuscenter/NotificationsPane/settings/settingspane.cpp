@@ -21,6 +21,7 @@
 #include "ui_settingspane.h"
 
 #include "applicationnotificationmodel.h"
+#include "notificationruledialog.h"
 #include <QSoundEffect>
 #include <QScroller>
 #include <QMessageBox>
@@ -29,6 +30,7 @@ struct SettingsPanePrivate {
     QSharedPointer<NotificationsPermissionEngine> currentSettings;
     QSettings settings;
     ApplicationNotificationModel* appsModel;
+    QList<NotificationRule> rules;
 };
 
 SettingsPane::SettingsPane(QWidget *parent) :
@@ -96,6 +98,10 @@ SettingsPane::SettingsPane(QWidget *parent) :
     ui->chargingSwitch->setChecked(d->settings.value("power/notifyConnectPower", true).toBool());
     ui->unplugSwitch->setChecked(d->settings.value("power/notifyUnplugPower", true).toBool());
     ui->notificationVolumeSlider->setValue(static_cast<int>(d->settings.value("notifications/volume", 1).toDouble() * 100));
+    ui->historyPerAppBox->setValue(d->settings.value("notifications/historyPerApp", 20).toInt());
+    ui->historyLimitBox->setValue(d->settings.value("notifications/historyLimit", 100).toInt());
+    loadRules();
+    connect(ui->rulesList, &QListWidget::itemDoubleClicked, this, &SettingsPane::on_editRuleButton_clicked);
 
     QScroller::grabGesture(ui->appList, QScroller::LeftMouseButtonGesture);
 }
@@ -187,22 +193,26 @@ void SettingsPane::on_attenuateOnNotification_toggled(bool checked)
 void SettingsPane::on_allowNotificationsMasterSwitch_toggled(bool checked)
 {
     d->currentSettings->setAllowNotifications(checked);
+    d->appsModel->updateApplication(*d->currentSettings);
     ui->notificationsConfigurationWidget->setEnabled(checked);
 }
 
 void SettingsPane::on_allowPopupsSwitch_toggled(bool checked)
 {
     d->currentSettings->setShowPopups(checked);
+    d->appsModel->updateApplication(*d->currentSettings);
 }
 
 void SettingsPane::on_allowSoundsSwitch_toggled(bool checked)
 {
     d->currentSettings->setPlaySound(checked);
+    d->appsModel->updateApplication(*d->currentSettings);
 }
 
 void SettingsPane::on_bypassQuietModeSwitch_toggled(bool checked)
 {
     d->currentSettings->setBypassesQuietMode(checked);
+    d->appsModel->updateApplication(*d->currentSettings);
 }
 
 void SettingsPane::on_connectMediaSwitch_toggled(bool checked)
@@ -225,11 +235,96 @@ void SettingsPane::on_notificationVolumeSlider_valueChanged(int value)
     d->settings.setValue("notifications/volume", static_cast<float>(value) / 100);
 }
 
+void SettingsPane::on_historyPerAppBox_valueChanged(int value)
+{
+    d->settings.setValue("notifications/historyPerApp", value);
+}
+
+void SettingsPane::on_historyLimitBox_valueChanged(int value)
+{
+    d->settings.setValue("notifications/historyLimit", value);
+}
+
+void SettingsPane::loadRules() {
+    d->rules = NotificationRules::instance()->rules();
+
+    ui->rulesList->clear();
+    for (NotificationRule rule : d->rules) {
+        QString name = rule.name.isEmpty() ? tr("Unnamed Rule") : rule.name;
+        if (!rule.valid) name = tr("%1 (not in effect)").arg(name);
+        ui->rulesList->addItem(name);
+    }
+    on_rulesList_currentRowChanged(ui->rulesList->currentRow());
+}
+
+void SettingsPane::saveRules(int currentRow) {
+    NotificationRules::instance()->setRules(d->rules);
+    loadRules();
+    ui->rulesList->setCurrentRow(currentRow);
+}
+
+void SettingsPane::on_addRuleButton_clicked()
+{
+    NotificationRuleDialog dialog(NotificationRule(), this);
+    if (dialog.exec() == QDialog::Accepted) {
+        d->rules.append(dialog.rule());
+        saveRules(d->rules.count() - 1);
+    }
+}
+
+void SettingsPane::on_editRuleButton_clicked()
+{
+    int row = ui->rulesList->currentRow();
+    if (row < 0 || row >= d->rules.count()) return;
+
+    NotificationRuleDialog dialog(d->rules.at(row), this);
+    if (dialog.exec() == QDialog::Accepted) {
+        d->rules.replace(row, dialog.rule());
+        saveRules(row);
+    }
+}
+
+void SettingsPane::on_removeRuleButton_clicked()
+{
+    int row = ui->rulesList->currentRow();
+    if (row < 0 || row >= d->rules.count()) return;
+
+    d->rules.removeAt(row);
+    saveRules(qMin(row, d->rules.count() - 1));
+}
+
+void SettingsPane::on_moveRuleUpButton_clicked()
+{
+    int row = ui->rulesList->currentRow();
+    if (row < 1 || row >= d->rules.count()) return;
+
+    d->rules.swap(row, row - 1);
+    saveRules(row - 1);
+}
+
+void SettingsPane::on_moveRuleDownButton_clicked()
+{
+    int row = ui->rulesList->currentRow();
+    if (row < 0 || row >= d->rules.count() - 1) return;
+
+    d->rules.swap(row, row + 1);
+    saveRules(row + 1);
+}
+
+void SettingsPane::on_rulesList_currentRowChanged(int currentRow)
+{
+    bool selected = currentRow >= 0;
+    ui->editRuleButton->setEnabled(selected);
+    ui->removeRuleButton->setEnabled(selected);
+    ui->moveRuleUpButton->setEnabled(currentRow > 0);
+    ui->moveRuleDownButton->setEnabled(selected && currentRow < d->rules.count() - 1);
+}
+
 void SettingsPane::on_removeNotificationButton_clicked()
 {
     if (QMessageBox::warning(this, tr("Mark as uninstalled?"), tr("This will remove the settings from theShell. If the application sends another notification, it will reappear.\n\nMark \"%1\" as uninstalled?").arg(d->currentSettings->appName()), QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::Yes) {
         d->currentSettings->remove();
-        d->appsModel->loadData();
+        d->appsModel->removeApplication(ui->appList->currentIndex());
         ui->appList->selectionModel()->setCurrentIndex(d->appsModel->index(0), QItemSelectionModel::ClearAndSelect);
     }
 }
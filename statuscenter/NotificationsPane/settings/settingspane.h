@@ -76,11 +76,30 @@ class SettingsPane : public QWidget, public StatusCenterPaneObject
 
         void on_notificationVolumeSlider_valueChanged(int value);
 
+        void on_historyPerAppBox_valueChanged(int value);
+
+        void on_historyLimitBox_valueChanged(int value);
+
+        void on_addRuleButton_clicked();
+
+        void on_editRuleButton_clicked();
+
+        void on_removeRuleButton_clicked();
+
+        void on_moveRuleUpButton_clicked();
+
+        void on_moveRuleDownButton_clicked();
+
+        void on_rulesList_currentRowChanged(int currentRow);
+
         void on_removeNotificationButton_clicked();
 
     private:
         Ui::SettingsPane *ui;
         SettingsPanePrivate* d;
+
+        void loadRules();
+        void saveRules(int currentRow);
 };
 
 #endif // SETTINGSPANE_H
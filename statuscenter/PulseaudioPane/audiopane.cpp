@@ -200,7 +200,7 @@ void AudioPane::addSoundSetting(QString name, QString soundName, QString soundPe
     playButton->setIcon(QIcon::fromTheme("audio-volume-high"));
     playButton->setFlat(true);
     connect(playButton, &QPushButton::clicked, [=] {
-        tSystemSound::play(soundName);
+        SoundEngine::play(soundName);
     });
 
     QSpacerItem* spacer = new QSpacerItem(0, 0, QSizePolicy::Expanding, QSizePolicy::Minimum);
@@ -0,0 +1,21 @@
+QT       += testlib
+QT       -= gui
+CONFIG   += c++14 console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_gesturerecognizer
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../../shell
+
+DEFINES += RECORDINGS_DIR=\\\"$$PWD/recordings\\\"
+
+SOURCES += \
+    tst_gesturerecognizer.cpp \
+    ../../shell/gestures/gesturerecognizer.cpp
+
+HEADERS += \
+    ../../shell/gestures/gesturerecognizer.h
+
+DISTFILES += \
+    recordings/*.rec
@@ -0,0 +1,132 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#include <QtTest>
+#include "gestures/gesturerecognizer.h"
+
+class GestureRecognizerTest : public QObject
+{
+        Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void replay_data();
+        void replay();
+
+    private:
+        //Feeds a recording to the recognizer the same way the XI2 filter does
+        bool play(QString recording, GestureRecognizer* recognizer);
+};
+
+void GestureRecognizerTest::initTestCase()
+{
+    qRegisterMetaType<GestureRecognizer::Gesture>();
+}
+
+bool GestureRecognizerTest::play(QString recording, GestureRecognizer* recognizer)
+{
+    QFile file(QString(RECORDINGS_DIR) + "/" + recording);
+    if (!file.open(QFile::ReadOnly)) return false;
+
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith("#")) continue;
+
+        //Each line is either "screen x y width height" or "time type id [x y]"
+        QStringList parts = line.split(" ", QString::SkipEmptyParts);
+        if (parts.first() == "screen") {
+            if (parts.count() != 5) return false;
+            recognizer->setScreenGeometry(QRectF(parts.at(1).toDouble(), parts.at(2).toDouble(), parts.at(3).toDouble(), parts.at(4).toDouble()));
+            continue;
+        }
+
+        if (parts.count() < 3) return false;
+        QString type = parts.at(1);
+        quint32 id = parts.at(2).toUInt();
+        if (type == "end") {
+            recognizer->touchEnd(id);
+        } else if (parts.count() == 5) {
+            QPointF point(parts.at(3).toDouble(), parts.at(4).toDouble());
+            if (type == "begin") {
+                recognizer->touchBegin(id, point);
+            } else if (type == "update") {
+                recognizer->touchUpdate(id, point);
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GestureRecognizerTest::replay_data()
+{
+    QTest::addColumn<QString>("recording");
+    QTest::addColumn<QString>("gesture");
+    QTest::addColumn<int>("fingers");
+    QTest::addColumn<bool>("committed");
+
+    QTest::newRow("edge swipe") << "edge-top.rec" << "edge-top" << 1 << true;
+    QTest::newRow("edge swipe let go early") << "edge-top-short.rec" << "edge-top" << 1 << false;
+    QTest::newRow("edge swipe on a second monitor") << "edge-left-second-monitor.rec" << "edge-left" << 1 << true;
+    QTest::newRow("three finger swipe") << "swipe-left.rec" << "swipe-left" << 3 << true;
+    QTest::newRow("four finger pinch") << "pinch-in.rec" << "pinch-in" << 4 << true;
+    QTest::newRow("two finger scroll") << "two-finger-scroll.rec" << "" << 0 << false;
+    QTest::newRow("tap") << "tap.rec" << "" << 0 << false;
+}
+
+void GestureRecognizerTest::replay()
+{
+    QFETCH(QString, recording);
+    QFETCH(QString, gesture);
+    QFETCH(int, fingers);
+    QFETCH(bool, committed);
+
+    GestureRecognizer recognizer;
+    QSignalSpy started(&recognizer, &GestureRecognizer::gestureStarted);
+    QSignalSpy finished(&recognizer, &GestureRecognizer::gestureFinished);
+    QSignalSpy cancelled(&recognizer, &GestureRecognizer::gestureCancelled);
+
+    QVERIFY2(play(recording, &recognizer), "Couldn't read the recording");
+    QCOMPARE(cancelled.count(), 0);
+
+    if (gesture.isEmpty()) {
+        QCOMPARE(started.count(), 0);
+        QCOMPARE(finished.count(), 0);
+        return;
+    }
+
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 1);
+
+    GestureRecognizer::Gesture result = finished.first().first().value<GestureRecognizer::Gesture>();
+    QCOMPARE(result.name(), gesture);
+    QCOMPARE(result.fingers, fingers);
+    QCOMPARE(result.progress >= 1, committed);
+
+    //Everything has been let go, so the next touch starts afresh
+    QVERIFY(!recognizer.isTracking(101));
+}
+
+QTEST_APPLESS_MAIN(GestureRecognizerTest)
+
+#include "tst_gesturerecognizer.moc"
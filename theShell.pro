@@ -12,6 +12,11 @@ statcenterproj.depends = theshell-lib
 daemonproj.subdir = daemons
 daemonproj.depends = theshell-lib
 
+testsproj.subdir = tests
+
+toolsproj.subdir = tools
+toolsproj.depends = theshell-lib
+
 SUBDIRS += \
     shellproj \
     startsession \
@@ -19,7 +24,9 @@ SUBDIRS += \
     polkitagent \
     mousepass \
     daemonproj \
-    theshell-lib
+    theshell-lib \
+    testsproj \
+    toolsproj
 
 blueprint {
     message(Configuring theShell to be built as blueprint)
@@ -0,0 +1,195 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#include "actiontracer.h"
+
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QTimer>
+#include <QX11Info>
+#include <QMap>
+#include <algorithm>
+
+#define TRACE_HISTORY 256
+
+struct ActionTrace {
+    QString action;
+
+    //All in microseconds; -1 if the stage was never reached
+    qint64 dispatch = -1; //From the X server timestamp to us seeing the event
+    qint64 handler = -1; //From seeing the event to the handler returning
+    qint64 paint = -1; //From seeing the event to the first paint
+};
+
+struct ActionTracerPrivate {
+    ActionTracer* instance = nullptr;
+    bool enabled = false;
+
+    QElapsedTimer clock;
+
+    //Difference between our clock and the X server clock, in milliseconds
+    qint64 serverOffset = 0;
+    qint64 lastCalibration = -1;
+
+    bool tracing = false;
+    qint64 traceStart;
+    ActionTrace current;
+    QTimer* commitTimer;
+
+    ActionTrace history[TRACE_HISTORY];
+    int historyCount = 0;
+    int historyIndex = 0;
+};
+
+ActionTracerPrivate* ActionTracer::d = new ActionTracerPrivate();
+
+ActionTracer::ActionTracer(QObject *parent) : QObject(parent)
+{
+    d->clock.start();
+
+    //Not every action paints, so give up waiting for a paint after a while
+    d->commitTimer = new QTimer(this);
+    d->commitTimer->setSingleShot(true);
+    d->commitTimer->setInterval(1000);
+    connect(d->commitTimer, &QTimer::timeout, this, &ActionTracer::commitTrace);
+
+    QDBusConnection::sessionBus().registerObject("/org/thesuite/theshell/ActionTrace", "org.thesuite.theshell.ActionTrace", this, QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableInvokables);
+
+    QSettings settings;
+    this->setEnabled(settings.value("debug/traceActions", false).toBool() || qEnvironmentVariableIsSet("THESHELL_TRACE_ACTIONS"));
+}
+
+ActionTracer* ActionTracer::instance()
+{
+    if (!d->instance) d->instance = new ActionTracer();
+    return d->instance;
+}
+
+bool ActionTracer::isTracing()
+{
+    return d->enabled;
+}
+
+void ActionTracer::beginTrace(QString action, quint32 serverTime)
+{
+    if (!d->enabled) return;
+    if (d->tracing) commitTrace();
+
+    //X server time wraps around every 49 days, so keep the calibration fresh
+    qint64 now = d->clock.nsecsElapsed() / 1000;
+    if (d->lastCalibration == -1 || now - d->lastCalibration > 300000000) calibrate();
+
+    d->tracing = true;
+    d->traceStart = d->clock.nsecsElapsed() / 1000;
+    d->current = ActionTrace();
+    d->current.action = action;
+    if (serverTime != 0) d->current.dispatch = qMax(qint64(0), (d->traceStart / 1000 - d->serverOffset - serverTime) * 1000);
+    d->commitTimer->start();
+}
+
+void ActionTracer::markHandled()
+{
+    if (!d->enabled || !d->tracing || d->current.handler != -1) return;
+    d->current.handler = d->clock.nsecsElapsed() / 1000 - d->traceStart;
+}
+
+void ActionTracer::markPainted()
+{
+    if (!d->enabled || !d->tracing) return;
+    d->current.paint = d->clock.nsecsElapsed() / 1000 - d->traceStart;
+    commitTrace();
+}
+
+void ActionTracer::commitTrace()
+{
+    if (!d->tracing) return;
+    d->tracing = false;
+    d->commitTimer->stop();
+
+    d->history[d->historyIndex] = d->current;
+    d->historyIndex = (d->historyIndex + 1) % TRACE_HISTORY;
+    if (d->historyCount < TRACE_HISTORY) d->historyCount++;
+}
+
+void ActionTracer::calibrate()
+{
+    //This is a round trip to the X server, so only do it every so often
+    qint64 before = d->clock.elapsed();
+    quint32 serverTime = QX11Info::getTimestamp();
+    qint64 after = d->clock.elapsed();
+
+    d->serverOffset = (before + after) / 2 - serverTime;
+    d->lastCalibration = after * 1000;
+}
+
+bool ActionTracer::enabled()
+{
+    return d->enabled;
+}
+
+void ActionTracer::setEnabled(bool enabled)
+{
+    d->enabled = enabled;
+    if (!enabled) {
+        d->tracing = false;
+        d->commitTimer->stop();
+    }
+}
+
+QString ActionTracer::percentiles()
+{
+    QMap<QString, QList<const ActionTrace*>> actions;
+    for (int i = 0; i < d->historyCount; i++) {
+        const ActionTrace* trace = &d->history[i];
+        actions[tr("All actions")].append(trace);
+        actions[trace->action].append(trace);
+    }
+
+    auto stage = [=](QList<const ActionTrace*> traces, qint64 ActionTrace::*field) {
+        QVector<qint64> values;
+        for (const ActionTrace* trace : traces) {
+            if (trace->*field != -1) values.append(trace->*field);
+        }
+        if (values.isEmpty()) return QString("-");
+        std::sort(values.begin(), values.end());
+
+        auto percentile = [=](int p) {
+            return QString::number(values.at(qMin(values.count() - 1, values.count() * p / 100)) / 1000.0, 'f', 2);
+        };
+        return QString("p50 %1 p90 %2 p99 %3 max %4").arg(percentile(50), percentile(90), percentile(99), percentile(100));
+    };
+
+    QStringList lines;
+    lines.append(tr("%n traces (times in ms)", nullptr, d->historyCount));
+    for (QString action : actions.keys()) {
+        QList<const ActionTrace*> traces = actions.value(action);
+        lines.append(QString("%1 (%2)").arg(action).arg(traces.count()));
+        lines.append("  dispatch: " + stage(traces, &ActionTrace::dispatch));
+        lines.append("  handler:  " + stage(traces, &ActionTrace::handler));
+        lines.append("  paint:    " + stage(traces, &ActionTrace::paint));
+    }
+    return lines.join("\n");
+}
+
+void ActionTracer::clear()
+{
+    d->historyCount = 0;
+    d->historyIndex = 0;
+}
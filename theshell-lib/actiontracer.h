@@ -0,0 +1,53 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#ifndef ACTIONTRACER_H
+#define ACTIONTRACER_H
+
+#include <QObject>
+
+struct ActionTracerPrivate;
+class ActionTracer : public QObject
+{
+        Q_OBJECT
+        Q_CLASSINFO("D-Bus Interface", "org.thesuite.theshell.ActionTrace")
+
+    public:
+        static ActionTracer* instance();
+
+        static bool isTracing();
+        static void beginTrace(QString action, quint32 serverTime);
+        static void markHandled();
+        static void markPainted();
+
+    public slots:
+        Q_SCRIPTABLE bool enabled();
+        Q_SCRIPTABLE void setEnabled(bool enabled);
+        Q_SCRIPTABLE QString percentiles();
+        Q_SCRIPTABLE void clear();
+
+    private:
+        explicit ActionTracer(QObject *parent = nullptr);
+        static ActionTracerPrivate* d;
+
+        static void commitTrace();
+        static void calibrate();
+};
+
+#endif // ACTIONTRACER_H
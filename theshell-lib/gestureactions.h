@@ -0,0 +1,49 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+#ifndef GESTUREACTIONS_H
+#define GESTUREACTIONS_H
+
+#include <QMap>
+#include <QString>
+#include <QSettings>
+
+//What each gesture does until the user picks something else in the Gestures pane.
+//Gestures missing from the table do nothing by default.
+namespace GestureActions {
+    inline QMap<QString, QString> defaults() {
+        return {
+            {"edge-top", "statuscenter"},
+            {"swipe-left", "next-desktop"},
+            {"swipe-right", "previous-desktop"},
+            {"pinch-in", "gateway"}
+        };
+    }
+
+    inline QString defaultAction(QString gesture) {
+        return defaults().value(gesture, "none");
+    }
+
+    inline QString action(QSettings& settings, QString gesture) {
+        return settings.value("gestures/action/" + gesture, defaultAction(gesture)).toString();
+    }
+}
+
+#endif // GESTUREACTIONS_H
@@ -37,6 +37,7 @@
 #include <QTimer>
 
 #include "keyboardtables.h"
+#include "actiontracer.h"
 
 struct GlobalKeyboardEnginePrivate {
     GlobalKeyboardEngine* instance = nullptr;
@@ -126,7 +127,9 @@ bool GlobalKeyboardEngine::nativeEventFilter(const QByteArray &eventType, void *
                 QTimer::singleShot(2000, d->shortcutDialog, &ShortcutInfoDialog::hide);
             } else {
                 if (matchingKeys.count() == 1) {
+                    if (ActionTracer::isTracing()) ActionTracer::beginTrace(matchingKeys.first()->name(), button->time);
                     emit matchingKeys.first()->shortcutActivated();
+                    ActionTracer::markHandled();
                     return true;
                 } else if (matchingKeys.count() > 1) {
                     //Conflict!!!!!!!
@@ -177,7 +180,10 @@ bool GlobalKeyboardEngine::nativeEventFilter(const QByteArray &eventType, void *
             if (d->heardSuper) {
                 d->heardSuper = false;
             } else {
-                emit d->keyMapping.value(QKeySequence(Qt::Key_Super_L))->shortcutActivated();
+                GlobalKeyboardKey* key = d->keyMapping.value(QKeySequence(Qt::Key_Super_L));
+                if (ActionTracer::isTracing()) ActionTracer::beginTrace(key->name(), button->time);
+                emit key->shortcutActivated();
+                ActionTracer::markHandled();
             }
         }
     }
@@ -368,6 +374,14 @@ QString GlobalKeyboardEngine::keyName(KnownKeyNames name) {
             return "System-PowerOptions";
         case Eject:
             return "System-Eject";
+        case MediaPlayPause:
+            return "Media-PlayPause";
+        case MediaNext:
+            return "Media-Next";
+        case MediaPrevious:
+            return "Media-Previous";
+        case MediaStop:
+            return "Media-Stop";
     }
 }
 
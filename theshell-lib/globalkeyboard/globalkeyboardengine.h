@@ -79,7 +79,11 @@ class GlobalKeyboardEngine : public QObject, public QAbstractNativeEventFilter
             KeyboardBrightnessDown,
             OpenGateway,
             PowerOptions,
-            Eject
+            Eject,
+            MediaPlayPause,
+            MediaNext,
+            MediaPrevious,
+            MediaStop
         };
         static QString keyName(KnownKeyNames name);
 
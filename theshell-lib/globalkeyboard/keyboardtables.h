@@ -445,6 +445,7 @@ static const unsigned int KeyTbl[] = {
     XF86XK_AudioMute,           Qt::Key_VolumeMute,
     XF86XK_AudioRaiseVolume,    Qt::Key_VolumeUp,
     XF86XK_AudioPlay,           Qt::Key_MediaPlay,
+    XF86XK_AudioPause,          Qt::Key_MediaPause,
     XF86XK_AudioStop,           Qt::Key_MediaStop,
     XF86XK_AudioPrev,           Qt::Key_MediaPrevious,
     XF86XK_AudioNext,           Qt::Key_MediaNext,
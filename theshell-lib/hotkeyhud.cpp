@@ -21,10 +21,11 @@
 #include "hotkeyhud.h"
 #include "ui_hotkeyhud.h"
 
-#include <QDBusInterface>
 #include <math.h>
 #include <globalkeyboard/globalkeyboardengine.h>
 #include <soundengine.h>
+#include <keyboardbacklightdaemon.h>
+#include <actiontracer.h>
 #include <tsystemsound.h>
 #include <QX11Info>
 #include <QScreen>
@@ -46,6 +47,9 @@ HotkeyHud::HotkeyHud(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    //Start tracking the keyboard backlight now so the first key press doesn't wait on UPower
+    KeyboardBacklightDaemon::instance();
+
     this->setWindowFlags(Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
     this->setAttribute(Qt::WA_ShowWithoutActivating, true);
 
@@ -86,33 +90,17 @@ HotkeyHud::HotkeyHud(QWidget *parent) :
             });
         } else if (name ==  GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::KeyboardBrightnessUp)) {
             connect(key, &GlobalKeyboardKey::shortcutActivated, this, [=] {
-                int kbdBrightness = -1, maxKbdBrightness = -1;
-                QDBusInterface keyboardInterface("org.freedesktop.UPower", "/org/freedesktop/UPower/KbdBacklight", "org.freedesktop.UPower.KbdBacklight", QDBusConnection::systemBus());
-                if (keyboardInterface.isValid()) {
-                    kbdBrightness = keyboardInterface.call("GetBrightness").arguments().first().toInt();
-                    maxKbdBrightness = keyboardInterface.call("GetMaxBrightness").arguments().first().toInt();
-                }
-
-                kbdBrightness += (((float) maxKbdBrightness / 100) * 5);
-                if (kbdBrightness > maxKbdBrightness) kbdBrightness = maxKbdBrightness;
-                keyboardInterface.call("SetBrightness", kbdBrightness);
-
-                HotkeyHud::show(QIcon::fromTheme("keyboard-brightness"), tr("Keyboard Brightness"), ((float) kbdBrightness / (float) maxKbdBrightness) * 100);
+                int percentage = KeyboardBacklightDaemon::adjustBrightness(5);
+                if (percentage == -1) return;
+
+                HotkeyHud::show(QIcon::fromTheme("keyboard-brightness"), tr("Keyboard Brightness"), percentage);
             });
         } else if (name ==  GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::KeyboardBrightnessDown)) {
             connect(key, &GlobalKeyboardKey::shortcutActivated, this, [=] {
-                int kbdBrightness = -1, maxKbdBrightness = -1;
-                QDBusInterface keyboardInterface("org.freedesktop.UPower", "/org/freedesktop/UPower/KbdBacklight", "org.freedesktop.UPower.KbdBacklight", QDBusConnection::systemBus());
-                if (keyboardInterface.isValid()) {
-                    kbdBrightness = keyboardInterface.call("GetBrightness").arguments().first().toInt();
-                    maxKbdBrightness = keyboardInterface.call("GetMaxBrightness").arguments().first().toInt();
-                }
-
-                kbdBrightness -= (((float) maxKbdBrightness / 100) * 5);
-                if (kbdBrightness < 0) kbdBrightness = 0;
-                keyboardInterface.call("SetBrightness", kbdBrightness);
-
-                HotkeyHud::show(QIcon::fromTheme("keyboard-brightness"), tr("Keyboard Brightness"), ((float) kbdBrightness / (float) maxKbdBrightness) * 100);
+                int percentage = KeyboardBacklightDaemon::adjustBrightness(-5);
+                if (percentage == -1) return;
+
+                HotkeyHud::show(QIcon::fromTheme("keyboard-brightness"), tr("Keyboard Brightness"), percentage);
             });
         } else if (name == GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::Eject)) {
             connect(key, &GlobalKeyboardKey::shortcutActivated, this, [=] {
@@ -167,6 +155,7 @@ void HotkeyHud::paintEvent(QPaintEvent *event) {
     }
 
     event->accept();
+    ActionTracer::markPainted();
 }
 
 void HotkeyHud::show(int timeout) {
@@ -268,7 +257,7 @@ void HotkeyHud::show(QVariantMap options) {
     }
 
     if (options.contains("sound")) {
-        tSystemSound::play(options.value("sound").toString());
+        SoundEngine::play(options.value("sound").toString());
     }
 
     d->instance->ui->explanation->setText(options.value("explanation", "").toString());
@@ -0,0 +1,162 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#include "keyboardbacklightdaemon.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusServiceWatcher>
+
+#define UPOWER_SERVICE "org.freedesktop.UPower"
+#define KBD_BACKLIGHT_PATH "/org/freedesktop/UPower/KbdBacklight"
+#define KBD_BACKLIGHT_INTERFACE "org.freedesktop.UPower.KbdBacklight"
+
+struct KeyboardBacklightDaemonPrivate {
+    KeyboardBacklightDaemon* instance = nullptr;
+
+    int brightness = -1;
+    int maxBrightness = -1;
+
+    //Number of SetBrightness calls that UPower hasn't answered yet.
+    //While this is non zero, BrightnessChanged signals are echoes of our own requests
+    //and would otherwise make the cached value jump backwards during key repeat.
+    int pendingSets = 0;
+};
+
+KeyboardBacklightDaemonPrivate* KeyboardBacklightDaemon::d = new KeyboardBacklightDaemonPrivate();
+
+KeyboardBacklightDaemon::KeyboardBacklightDaemon(QObject *parent) : QObject(parent)
+{
+    QDBusConnection::systemBus().connect(UPOWER_SERVICE, KBD_BACKLIGHT_PATH, KBD_BACKLIGHT_INTERFACE, "BrightnessChanged", this, SLOT(upowerBrightnessChanged(int)));
+    QDBusConnection::systemBus().connect(UPOWER_SERVICE, KBD_BACKLIGHT_PATH, KBD_BACKLIGHT_INTERFACE, "BrightnessChangedWithSource", this, SLOT(upowerBrightnessChangedWithSource(int,QString)));
+
+    QDBusServiceWatcher* watcher = new QDBusServiceWatcher(UPOWER_SERVICE, QDBusConnection::systemBus(), QDBusServiceWatcher::WatchForRegistration, this);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered, this, [=] {
+        //UPower restarted; anything we asked the old instance is lost
+        d->pendingSets = 0;
+        refresh();
+    });
+}
+
+KeyboardBacklightDaemon* KeyboardBacklightDaemon::instance()
+{
+    if (!d->instance) {
+        d->instance = new KeyboardBacklightDaemon();
+        refresh();
+    }
+    return d->instance;
+}
+
+void KeyboardBacklightDaemon::refresh()
+{
+    QDBusMessage maxMessage = QDBusMessage::createMethodCall(UPOWER_SERVICE, KBD_BACKLIGHT_PATH, KBD_BACKLIGHT_INTERFACE, "GetMaxBrightness");
+    QDBusPendingCallWatcher* maxWatcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(maxMessage));
+    connect(maxWatcher, &QDBusPendingCallWatcher::finished, d->instance, [=] {
+        if (!maxWatcher->isError()) {
+            bool wasAvailable = isAvailable();
+            d->maxBrightness = maxWatcher->reply().arguments().first().toInt();
+            if (wasAvailable != isAvailable()) emit d->instance->availableChanged(isAvailable());
+        }
+        maxWatcher->deleteLater();
+    });
+
+    QDBusMessage brightnessMessage = QDBusMessage::createMethodCall(UPOWER_SERVICE, KBD_BACKLIGHT_PATH, KBD_BACKLIGHT_INTERFACE, "GetBrightness");
+    QDBusPendingCallWatcher* brightnessWatcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(brightnessMessage));
+    connect(brightnessWatcher, &QDBusPendingCallWatcher::finished, d->instance, [=] {
+        if (!brightnessWatcher->isError() && d->pendingSets == 0) {
+            d->instance->upowerBrightnessChanged(brightnessWatcher->reply().arguments().first().toInt());
+        }
+        brightnessWatcher->deleteLater();
+    });
+}
+
+bool KeyboardBacklightDaemon::isAvailable()
+{
+    return d->maxBrightness > 0;
+}
+
+int KeyboardBacklightDaemon::brightness()
+{
+    return d->brightness;
+}
+
+int KeyboardBacklightDaemon::maxBrightness()
+{
+    return d->maxBrightness;
+}
+
+int KeyboardBacklightDaemon::brightnessPercentage()
+{
+    if (!isAvailable() || d->brightness < 0) return -1;
+    return qRound(static_cast<float>(d->brightness) / d->maxBrightness * 100);
+}
+
+void KeyboardBacklightDaemon::setBrightness(int brightness)
+{
+    instance();
+    if (!isAvailable()) return;
+
+    brightness = qBound(0, brightness, d->maxBrightness);
+    if (brightness != d->brightness) {
+        d->brightness = brightness;
+        emit d->instance->brightnessChanged(brightness);
+    }
+
+    QDBusMessage message = QDBusMessage::createMethodCall(UPOWER_SERVICE, KBD_BACKLIGHT_PATH, KBD_BACKLIGHT_INTERFACE, "SetBrightness");
+    message.setArguments({brightness});
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message));
+    d->pendingSets++;
+    connect(watcher, &QDBusPendingCallWatcher::finished, d->instance, [=] {
+        if (d->pendingSets > 0) d->pendingSets--;
+        if (watcher->isError() && d->pendingSets == 0) {
+            //The request didn't go through, so find out what the keyboard is actually set to
+            refresh();
+        }
+        watcher->deleteLater();
+    });
+}
+
+int KeyboardBacklightDaemon::adjustBrightness(int percentage)
+{
+    instance();
+    if (!isAvailable() || d->brightness < 0) return -1;
+
+    //Always move by at least one step so keyboards with few levels still respond
+    int step = qRound(static_cast<float>(d->maxBrightness) / 100 * qAbs(percentage));
+    if (step == 0) step = 1;
+    setBrightness(d->brightness + (percentage < 0 ? -step : step));
+    return brightnessPercentage();
+}
+
+void KeyboardBacklightDaemon::upowerBrightnessChanged(int brightness)
+{
+    if (d->pendingSets > 0) return; //Ignore echoes of our own requests
+    if (brightness != d->brightness) {
+        d->brightness = brightness;
+        emit brightnessChanged(brightness);
+    }
+}
+
+void KeyboardBacklightDaemon::upowerBrightnessChangedWithSource(int brightness, QString source)
+{
+    //Changes made by the firmware (e.g. Fn key handled in hardware) are never our echoes
+    if (source == "internal") d->pendingSets = 0;
+    upowerBrightnessChanged(brightness);
+}
@@ -0,0 +1,55 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#ifndef KEYBOARDBACKLIGHTDAEMON_H
+#define KEYBOARDBACKLIGHTDAEMON_H
+
+#include <QObject>
+
+struct KeyboardBacklightDaemonPrivate;
+class KeyboardBacklightDaemon : public QObject
+{
+        Q_OBJECT
+    public:
+        static KeyboardBacklightDaemon* instance();
+
+        static bool isAvailable();
+        static int brightness();
+        static int maxBrightness();
+        static int brightnessPercentage();
+
+        static void setBrightness(int brightness);
+        static int adjustBrightness(int percentage);
+
+    signals:
+        void brightnessChanged(int brightness);
+        void availableChanged(bool available);
+
+    private slots:
+        void upowerBrightnessChanged(int brightness);
+        void upowerBrightnessChangedWithSource(int brightness, QString source);
+
+    private:
+        explicit KeyboardBacklightDaemon(QObject *parent = nullptr);
+        static KeyboardBacklightDaemonPrivate* d;
+
+        static void refresh();
+};
+
+#endif // KEYBOARDBACKLIGHTDAEMON_H
@@ -0,0 +1,166 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#include "albumartcache.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QDir>
+#include <QFile>
+#include <QUrl>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+struct AlbumArtCachePrivate {
+    QMutex lock;
+
+    //Scaled variants keyed by content hash and size, so identical covers share one entry
+    QCache<QString, QImage> images{16 * 1024 * 1024};
+
+    //Content hash of whatever a URL pointed at for a given revision; players reuse URLs across tracks
+    QCache<QString, QString> sourceHashes{256};
+};
+
+AlbumArtCachePrivate* AlbumArtCache::d = new AlbumArtCachePrivate();
+
+QImage AlbumArtCache::cachedAlbumArt(QString url, QSize size, QString revision) {
+    QString source = sourceKey(url, revision);
+
+    QMutexLocker locker(&d->lock);
+    QString* hash = d->sourceHashes.object(source);
+    if (hash == nullptr) return QImage();
+
+    QImage* image = d->images.object(variantKey(*hash, size));
+    if (image == nullptr) return QImage();
+    return *image;
+}
+
+tPromise<QImage>* AlbumArtCache::albumArt(QString url, QSize size, QString revision) {
+    return new tPromise<QImage>([=](QString& error) -> QImage {
+        QImage image = cachedAlbumArt(url, size, revision);
+        if (!image.isNull()) return image;
+
+        return loadAlbumArt(url, size, revision, error);
+    });
+}
+
+QString AlbumArtCache::sourceKey(QString url, QString revision) {
+    //Local files can be rewritten in place, so their modification time is part of the revision too
+    QUrl artUrl(url);
+    if (artUrl.isLocalFile()) {
+        QFileInfo file(artUrl.toLocalFile());
+        revision += QString("@%1:%2").arg(file.lastModified().toMSecsSinceEpoch()).arg(file.size());
+    }
+    return url + "\n" + revision;
+}
+
+QImage AlbumArtCache::loadAlbumArt(QString url, QSize size, QString revision, QString& error) {
+    //This runs on a worker thread
+    QString source = sourceKey(url, revision);
+    QUrl artUrl(url);
+    QByteArray data;
+    if (artUrl.isLocalFile()) {
+        QFile file(artUrl.toLocalFile());
+        if (!file.open(QFile::ReadOnly)) {
+            error = "Couldn't open album art";
+            return QImage();
+        }
+        data = file.readAll();
+    } else if (artUrl.scheme() == "http" || artUrl.scheme() == "https") {
+        QNetworkAccessManager mgr;
+        QEventLoop loop;
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        timeout.setInterval(10000);
+
+        QNetworkReply* reply = mgr.get(QNetworkRequest(artUrl));
+        QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        QObject::connect(&timeout, &QTimer::timeout, reply, &QNetworkReply::abort);
+        timeout.start();
+        loop.exec();
+
+        if (reply->error() != QNetworkReply::NoError) {
+            error = timeout.isActive() ? reply->errorString() : "Timed out fetching album art";
+            reply->deleteLater();
+            return QImage();
+        }
+        data = reply->readAll();
+        reply->deleteLater();
+    } else {
+        error = "Unsupported album art URL";
+        return QImage();
+    }
+
+    QString hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    QString key = variantKey(hash, size);
+
+    QImage image;
+    {
+        QMutexLocker locker(&d->lock);
+        d->sourceHashes.insert(source, new QString(hash));
+        if (d->images.contains(key)) return *d->images.object(key);
+    }
+
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/albumart");
+    QString cacheFile = cacheDir.absoluteFilePath(key + ".png");
+    if (image.load(cacheFile)) {
+        //Mark this variant as recently used
+        QFile file(cacheFile);
+        if (file.open(QFile::ReadWrite)) file.setFileTime(QDateTime::currentDateTime(), QFile::FileModificationTime);
+    } else {
+        image = QImage::fromData(data);
+        if (image.isNull()) {
+            error = "Couldn't decode album art";
+            return QImage();
+        }
+
+        image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        cacheDir.mkpath(".");
+        image.save(cacheFile, "PNG");
+        evict();
+    }
+
+    QMutexLocker locker(&d->lock);
+    d->images.insert(key, new QImage(image), static_cast<int>(image.sizeInBytes()));
+    return image;
+}
+
+QString AlbumArtCache::variantKey(QString hash, QSize size) {
+    return QString("%1-%2x%3").arg(hash).arg(size.width()).arg(size.height());
+}
+
+void AlbumArtCache::evict() {
+    QSettings settings;
+    qint64 maximumSize = settings.value("mpris/albumArtCacheSize", 20).toLongLong() * 1024 * 1024;
+
+    //Newest first; anything past the limit is the least recently used
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/albumart");
+    qint64 totalSize = 0;
+    for (QFileInfo file : cacheDir.entryInfoList(QDir::Files, QDir::Time)) {
+        totalSize += file.size();
+        if (totalSize > maximumSize) QFile::remove(file.filePath());
+    }
+}
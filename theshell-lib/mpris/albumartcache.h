@@ -0,0 +1,43 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#ifndef ALBUMARTCACHE_H
+#define ALBUMARTCACHE_H
+
+#include <QImage>
+#include <tpromise.h>
+
+struct AlbumArtCachePrivate;
+class AlbumArtCache
+{
+    public:
+        static tPromise<QImage>* albumArt(QString url, QSize size, QString revision = "");
+        static QImage cachedAlbumArt(QString url, QSize size, QString revision = "");
+
+    private:
+        AlbumArtCache() = delete;
+        static AlbumArtCachePrivate* d;
+
+        static QImage loadAlbumArt(QString url, QSize size, QString revision, QString& error);
+        static QString sourceKey(QString url, QString revision);
+        static QString variantKey(QString hash, QSize size);
+        static void evict();
+};
+
+#endif // ALBUMARTCACHE_H
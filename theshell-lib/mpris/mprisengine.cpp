@@ -21,10 +21,13 @@
 
 #include <QTimer>
 #include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 
 struct MprisEnginePrivate {
     MprisEngine* instance = nullptr;
     QMap<QString, MprisPlayerPtr> players;
+    QMap<QString, MprisPlayerPtr> pendingPlayers;
 };
 
 MprisEnginePrivate* MprisEngine::d = new MprisEnginePrivate;
@@ -32,9 +35,15 @@ MprisEnginePrivate* MprisEngine::d = new MprisEnginePrivate;
 MprisEngine::MprisEngine(QObject *parent) : QObject(parent)
 {
     connect(QDBusConnection::sessionBus().interface(), &QDBusConnectionInterface::serviceOwnerChanged, this, &MprisEngine::serviceOwnerChanged);
-    for (QString service : QDBusConnection::sessionBus().interface()->registeredServiceNames().value()) {
-        if (service.startsWith("org.mpris.MediaPlayer2.")) registerPlayer(service);
-    }
+
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().interface()->asyncCall("ListNames"), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+        QDBusPendingReply<QStringList> reply = *watcher;
+        for (QString service : reply.value()) {
+            if (service.startsWith("org.mpris.MediaPlayer2.")) registerPlayer(service);
+        }
+        watcher->deleteLater();
+    });
 }
 
 MprisEngine* MprisEngine::instance() {
@@ -64,13 +73,22 @@ MprisPlayerPtr MprisEngine::playerForInterface(QString interface) {
 }
 
 void MprisEngine::registerPlayer(QString service) {
-    MprisPlayerPtr player(new MprisPlayer(service));
-    d->players.insert(service, player);
+    if (d->players.contains(service) || d->pendingPlayers.contains(service)) return; //Already tracking this player
+
+    //Players are only announced once they've answered with their properties
+    //The engine may hold the only reference when gone is emitted, so don't delete the player from inside its own signal
+    MprisPlayerPtr player(new MprisPlayer(service), &QObject::deleteLater);
+    d->pendingPlayers.insert(service, player);
+    connect(player.get(), &MprisPlayer::ready, this, [=] {
+        if (!d->pendingPlayers.contains(service)) return;
+        MprisPlayerPtr readyPlayer = d->pendingPlayers.take(service);
+        d->players.insert(service, readyPlayer);
+        emit newPlayer(service, readyPlayer);
+    });
     connect(player.get(), &MprisPlayer::gone, this, [=] {
-        d->players.remove(service);
-        emit playerGone(service);
+        d->pendingPlayers.remove(service);
+        if (d->players.remove(service) > 0) emit playerGone(service);
     });
-    emit newPlayer(service, player);
 }
 
 QList<MprisPlayerPtr> MprisEngine::players() {
@@ -0,0 +1,190 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#include "mprishub.h"
+
+#include <QSettings>
+#include <QDateTime>
+#include <algorithm>
+#include "mprisengine.h"
+#include "globalkeyboard/globalkeyboardengine.h"
+
+struct MprisHubPrivate {
+    MprisHub* instance = nullptr;
+    QString pinnedPlayer;
+
+    QList<MprisPlayerPtr> players;
+    QMap<QString, qint64> lastActivity;
+    MprisPlayerPtr currentPlayer;
+};
+
+MprisHubPrivate* MprisHub::d = new MprisHubPrivate();
+
+MprisHub::MprisHub(QObject *parent) : QObject(parent)
+{
+    QSettings settings;
+    d->pinnedPlayer = settings.value("mpris/pinnedPlayer").toString();
+
+    for (MprisPlayerPtr player : MprisEngine::players()) {
+        addPlayer(player);
+    }
+    connect(MprisEngine::instance(), &MprisEngine::newPlayer, this, [=](QString service, MprisPlayerPtr player) {
+        Q_UNUSED(service)
+        addPlayer(player);
+    });
+    connect(MprisEngine::instance(), &MprisEngine::playerGone, this, &MprisHub::removePlayer);
+
+    //Media keys always go to whichever player the hub has chosen
+    connect(GlobalKeyboardEngine::instance(), &GlobalKeyboardEngine::keyShortcutRegistered, this, [=](QString name, GlobalKeyboardKey* key) {
+        if (name == GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaPlayPause)) {
+            connect(key, &GlobalKeyboardKey::shortcutActivated, this, &MprisHub::playPause);
+        } else if (name == GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaNext)) {
+            connect(key, &GlobalKeyboardKey::shortcutActivated, this, &MprisHub::next);
+        } else if (name == GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaPrevious)) {
+            connect(key, &GlobalKeyboardKey::shortcutActivated, this, &MprisHub::previous);
+        } else if (name == GlobalKeyboardEngine::keyName(GlobalKeyboardEngine::MediaStop)) {
+            connect(key, &GlobalKeyboardKey::shortcutActivated, this, &MprisHub::stop);
+        }
+    });
+}
+
+MprisHub* MprisHub::instance() {
+    if (d->instance == nullptr) d->instance = new MprisHub();
+    return d->instance;
+}
+
+void MprisHub::addPlayer(MprisPlayerPtr player) {
+    if (d->players.contains(player)) return;
+
+    QString service = player->service();
+    d->players.append(player);
+    d->lastActivity.insert(service, player->playbackStatus() == MprisPlayer::Playing ? QDateTime::currentMSecsSinceEpoch() : 0);
+
+    connect(player.data(), &MprisPlayer::stateChanged, this, [=](MprisPlayer::StateProperties changed) {
+        if (changed.testFlag(MprisPlayer::PlaybackStatusProperty)) {
+            d->lastActivity.insert(service, QDateTime::currentMSecsSinceEpoch());
+            chooseCurrentPlayer();
+        }
+    });
+
+    emit playersChanged();
+    chooseCurrentPlayer();
+}
+
+void MprisHub::removePlayer(QString service) {
+    for (MprisPlayerPtr player : d->players) {
+        if (player->service() == service) {
+            player->disconnect(this);
+            d->players.removeOne(player);
+            d->lastActivity.remove(service);
+            if (d->currentPlayer == player) d->currentPlayer.clear();
+
+            emit playersChanged();
+            chooseCurrentPlayer();
+            return;
+        }
+    }
+}
+
+void MprisHub::chooseCurrentPlayer() {
+    QList<MprisPlayerPtr> players = MprisHub::players();
+    MprisPlayerPtr chosen = players.isEmpty() ? MprisPlayerPtr() : players.first();
+
+    if (chosen != d->currentPlayer) {
+        d->currentPlayer = chosen;
+        emit currentPlayerChanged(chosen);
+    }
+}
+
+MprisPlayerPtr MprisHub::currentPlayer() {
+    MprisHub::instance();
+    return d->currentPlayer;
+}
+
+QList<MprisPlayerPtr> MprisHub::players() {
+    MprisHub::instance();
+
+    //A pinned player always wins, then playing players, then whichever changed state most recently
+    QList<MprisPlayerPtr> players = d->players;
+    std::stable_sort(players.begin(), players.end(), [=](const MprisPlayerPtr& first, const MprisPlayerPtr& second) {
+        bool firstPinned = isPinned(first);
+        if (firstPinned != isPinned(second)) return firstPinned;
+
+        bool firstPlaying = first->playbackStatus() == MprisPlayer::Playing;
+        if (firstPlaying != (second->playbackStatus() == MprisPlayer::Playing)) return firstPlaying;
+
+        return d->lastActivity.value(first->service()) > d->lastActivity.value(second->service());
+    });
+    return players;
+}
+
+void MprisHub::setCurrentPlayer(MprisPlayerPtr player) {
+    MprisHub::instance();
+    if (!d->players.contains(player)) return;
+
+    //Treat an explicit choice as activity so it stays chosen until another player changes state
+    d->lastActivity.insert(player->service(), QDateTime::currentMSecsSinceEpoch());
+    if (d->currentPlayer != player) {
+        d->currentPlayer = player;
+        emit d->instance->currentPlayerChanged(player);
+    }
+}
+
+QString MprisHub::pinKey(MprisPlayerPtr player) {
+    //Service names of multi-instance players include a process ID, so prefer something stable
+    if (!player->desktopEntry().isEmpty()) return player->desktopEntry();
+    if (!player->identity().isEmpty()) return player->identity();
+    return player->service();
+}
+
+bool MprisHub::isPinned(MprisPlayerPtr player) {
+    if (player.isNull() || d->pinnedPlayer.isEmpty()) return false;
+    return d->pinnedPlayer == pinKey(player);
+}
+
+void MprisHub::setPinned(MprisPlayerPtr player, bool pinned) {
+    MprisHub::instance();
+    if (pinned) {
+        d->pinnedPlayer = pinKey(player);
+    } else if (isPinned(player)) {
+        d->pinnedPlayer.clear();
+    }
+
+    QSettings settings;
+    settings.setValue("mpris/pinnedPlayer", d->pinnedPlayer);
+
+    emit d->instance->playersChanged();
+    d->instance->chooseCurrentPlayer();
+}
+
+void MprisHub::playPause() {
+    if (!d->currentPlayer.isNull()) d->currentPlayer->playPause();
+}
+
+void MprisHub::next() {
+    if (!d->currentPlayer.isNull()) d->currentPlayer->next();
+}
+
+void MprisHub::previous() {
+    if (!d->currentPlayer.isNull()) d->currentPlayer->previous();
+}
+
+void MprisHub::stop() {
+    if (!d->currentPlayer.isNull()) d->currentPlayer->stop();
+}
@@ -0,0 +1,61 @@
+/****************************************
+ *
+ *   INSERT-PROJECT-NAME-HERE - INSERT-GENERIC-NAME-HERE
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+#ifndef MPRISHUB_H
+#define MPRISHUB_H
+
+#include <QObject>
+#include "mprisplayer.h"
+
+struct MprisHubPrivate;
+class MprisHub : public QObject
+{
+        Q_OBJECT
+    public:
+        static MprisHub* instance();
+
+        static MprisPlayerPtr currentPlayer();
+        static QList<MprisPlayerPtr> players();
+
+        static void setCurrentPlayer(MprisPlayerPtr player);
+
+        static bool isPinned(MprisPlayerPtr player);
+        static void setPinned(MprisPlayerPtr player, bool pinned);
+
+    signals:
+        void currentPlayerChanged(MprisPlayerPtr player);
+        void playersChanged();
+
+    public slots:
+        void playPause();
+        void next();
+        void previous();
+        void stop();
+
+    private:
+        explicit MprisHub(QObject *parent = T_QOBJECT_ROOT);
+        static MprisHubPrivate* d;
+
+        void addPlayer(MprisPlayerPtr player);
+        void removePlayer(QString service);
+        void chooseCurrentPlayer();
+        static QString pinKey(MprisPlayerPtr player);
+};
+
+#endif // MPRISHUB_H
@@ -20,90 +20,259 @@
 #include "mprisplayer.h"
 
 #include <QDebug>
-#include <QDBusInterface>
-#include <QDBusPendingCall>
+#include <QDBusMessage>
+#include <QDBusArgument>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusConnectionInterface>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#define MPRIS_PATH "/org/mpris/MediaPlayer2"
+#define MPRIS_ROOT_INTERFACE "org.mpris.MediaPlayer2"
+#define MPRIS_PLAYER_INTERFACE "org.mpris.MediaPlayer2.Player"
+
+namespace {
+    //Every property we track, along with the signal to emit when it changes
+    struct PropertyHandler {
+        const char* interface;
+        const char* remoteProperty;
+        MprisPlayer::StateProperty property;
+        void (MprisPlayer::*changed)();
+    };
+
+    const PropertyHandler propertyHandlers[] = {
+        {MPRIS_ROOT_INTERFACE, "CanQuit", MprisPlayer::CanQuitProperty, &MprisPlayer::canQuitChanged},
+        {MPRIS_ROOT_INTERFACE, "Fullscreen", MprisPlayer::IsFullscreenProperty, &MprisPlayer::isFullscreenChanged},
+        {MPRIS_ROOT_INTERFACE, "CanSetFullscreen", MprisPlayer::CanFullscreenProperty, &MprisPlayer::canFullscreenChanged},
+        {MPRIS_ROOT_INTERFACE, "CanRaise", MprisPlayer::CanRaiseProperty, &MprisPlayer::canRaiseChanged},
+        {MPRIS_ROOT_INTERFACE, "HasTrackList", MprisPlayer::HasTrackListProperty, &MprisPlayer::hasTrackListChanged},
+        {MPRIS_ROOT_INTERFACE, "Identity", MprisPlayer::IdentityProperty, &MprisPlayer::identityChanged},
+        {MPRIS_ROOT_INTERFACE, "DesktopEntry", MprisPlayer::DesktopEntryProperty, &MprisPlayer::desktopEntryChanged},
+        {MPRIS_PLAYER_INTERFACE, "PlaybackStatus", MprisPlayer::PlaybackStatusProperty, &MprisPlayer::playbackStatusChanged},
+        {MPRIS_PLAYER_INTERFACE, "LoopStatus", MprisPlayer::RepeatingProperty, &MprisPlayer::repeatingChanged},
+        {MPRIS_PLAYER_INTERFACE, "Rate", MprisPlayer::RateProperty, &MprisPlayer::rateChanged},
+        {MPRIS_PLAYER_INTERFACE, "Shuffle", MprisPlayer::ShuffleProperty, &MprisPlayer::shuffleChanged},
+        {MPRIS_PLAYER_INTERFACE, "Metadata", MprisPlayer::MetadataProperty, &MprisPlayer::metadataChanged},
+        {MPRIS_PLAYER_INTERFACE, "Volume", MprisPlayer::VolumeProperty, &MprisPlayer::volumeChanged},
+        {MPRIS_PLAYER_INTERFACE, "MinimumRate", MprisPlayer::MinRateProperty, &MprisPlayer::minRateChanged},
+        {MPRIS_PLAYER_INTERFACE, "MaximumRate", MprisPlayer::MaxRateProperty, &MprisPlayer::maxRateChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanGoNext", MprisPlayer::CanGoNextProperty, &MprisPlayer::canGoNextChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanGoPrevious", MprisPlayer::CanGoPreviousProperty, &MprisPlayer::canGoPreviousChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanPlay", MprisPlayer::CanPlayProperty, &MprisPlayer::canPlayChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanPause", MprisPlayer::CanPauseProperty, &MprisPlayer::canPauseChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanSeek", MprisPlayer::CanSeekProperty, &MprisPlayer::canSeekChanged},
+        {MPRIS_PLAYER_INTERFACE, "CanControl", MprisPlayer::CanControlProperty, &MprisPlayer::canControlChanged}
+    };
+
+    const int PropertyCount = sizeof(propertyHandlers) / sizeof(PropertyHandler);
+
+    int propertyIndex(MprisPlayer::StateProperty property) {
+        return static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(property)));
+    }
+
+    const PropertyHandler* handlerFor(const QString& interface, const QString& remoteProperty) {
+        //Built once; lookups only hash the property name
+        static QHash<QString, QHash<QString, const PropertyHandler*>> handlers;
+        if (handlers.isEmpty()) {
+            for (const PropertyHandler& handler : propertyHandlers) {
+                handlers[QString::fromLatin1(handler.interface)].insert(QString::fromLatin1(handler.remoteProperty), &handler);
+            }
+        }
+
+        auto interfaceHandlers = handlers.constFind(interface);
+        if (interfaceHandlers == handlers.constEnd()) return nullptr;
+        return interfaceHandlers->value(remoteProperty, nullptr);
+    }
+}
 
 struct MprisPlayerPrivate {
-    QDBusInterface *interface, *player;
+    QString service;
+
+    QVariant properties[PropertyCount];
 
-    QMap<QString, QVariant> properties;
-    QMap<QString, QString> propertyMappings;
+    //Changes received since the last time they were applied
+    QVariant pendingProperties[PropertyCount];
+    MprisPlayer::StateProperties pendingChanges;
 
-//    bool canQuit, fullscreen, canFullscreen, canRaise, hasTrackList;
-//    QString identity, desktopEntry;
-//    MprisPlayer::PlayingStatus status;
+    int pendingInterfaces = 0;
+    bool ready = false;
+
+    //Position is never announced through PropertiesChanged, so it's interpolated from the last known value
+    qint64 knownPosition = 0;
+    QElapsedTimer positionClock;
+    QTimer* positionSyncTimer;
 };
 
 MprisPlayer::MprisPlayer(QString service, QObject *parent) : QObject(parent)
 {
     d = new MprisPlayerPrivate();
-    d->interface = new QDBusInterface(service, "/org/mpris/MediaPlayer2", "org.mpris.MediaPlayer2");
-    d->player = new QDBusInterface(service, "/org/mpris/MediaPlayer2", "org.mpris.MediaPlayer2.Player");
+    d->service = service;
 
     connect(QDBusConnection::sessionBus().interface(), &QDBusConnectionInterface::serviceOwnerChanged, this, &MprisPlayer::serviceOwnerChanged);
-    QDBusConnection::sessionBus().connect(service, "/org/mpris/MediaPlayer2", "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(dbusPropertyChanged(QString,QMap<QString, QVariant>,QStringList)));
-    QDBusConnection::sessionBus().connect(service, "/org/mpris/MediaPlayer2", "org.mpris.MediaPlayer2.Player", "Seeked", this, SIGNAL(seeked(qint64)));
-
-    registerDbusProperty(d->interface, "canQuit", "CanQuit");
-    registerDbusProperty(d->interface, "isFullscreen", "Fullscreen");
-    registerDbusProperty(d->interface, "canFullscreen", "CanSetFullscreen");
-    registerDbusProperty(d->interface, "canRaise", "CanRaise");
-    registerDbusProperty(d->interface, "hasTrackList", "HasTrackList");
-    registerDbusProperty(d->interface, "identity", "Identity");
-    registerDbusProperty(d->interface, "desktopEntry", "DesktopEntry");
-
-    registerDbusProperty(d->player, "playbackStatus", "PlaybackStatus");
-    registerDbusProperty(d->player, "repeating", "LoopStatus");
-    registerDbusProperty(d->player, "rate", "Rate");
-    registerDbusProperty(d->player, "shuffle", "Shuffle");
-    registerDbusProperty(d->player, "metadata", "Metadata");
-    registerDbusProperty(d->player, "volume", "Volume");
-    registerDbusProperty(d->player, "minRate", "MinimumRate");
-    registerDbusProperty(d->player, "maxRate", "MaximumRate");
-    registerDbusProperty(d->player, "canGoNext", "CanGoNext");
-    registerDbusProperty(d->player, "canGoPrevious", "CanGoPrevious");
-    registerDbusProperty(d->player, "canPlay", "CanPlay");
-    registerDbusProperty(d->player, "canPause", "CanPause");
-    registerDbusProperty(d->player, "canSeek", "CanSeek");
+    QDBusConnection::sessionBus().connect(service, MPRIS_PATH, "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(dbusPropertyChanged(QString,QMap<QString, QVariant>,QStringList)));
+    QDBusConnection::sessionBus().connect(service, MPRIS_PATH, MPRIS_PLAYER_INTERFACE, "Seeked", this, SLOT(dbusSeeked(qint64)));
+
+    //Occasionally check the interpolated position against the player while it's playing
+    d->positionSyncTimer = new QTimer(this);
+    d->positionSyncTimer->setInterval(60000);
+    connect(d->positionSyncTimer, &QTimer::timeout, this, &MprisPlayer::fetchPosition);
+
+    //Fetch everything with one GetAll per interface so a slow player can't hold up the shell
+    fetchDbusProperties(MPRIS_ROOT_INTERFACE);
+    fetchDbusProperties(MPRIS_PLAYER_INTERFACE);
 }
 
 MprisPlayer::~MprisPlayer() {
-    d->player->deleteLater();
-    d->interface->deleteLater();
     delete d;
 }
 
-void MprisPlayer::registerDbusProperty(QDBusInterface* interface, QString localProperty, QString remoteProperty) {
-    QDBusMessage message = QDBusMessage::createMethodCall(interface->service(), interface->path(), "org.freedesktop.DBus.Properties", "Get");
+void MprisPlayer::fetchDbusProperties(QString interface) {
+    QDBusMessage message = QDBusMessage::createMethodCall(d->service, MPRIS_PATH, "org.freedesktop.DBus.Properties", "GetAll");
+    message.setArguments({interface});
+
+    d->pendingInterfaces++;
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+        QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (reply.isError()) {
+            qDebug() << "MPRIS player" << d->service << "failed to return properties for" << interface << ":" << reply.error().message();
+        } else {
+            dbusPropertyChanged(interface, reply.value(), QStringList());
+        }
+
+        d->pendingInterfaces--;
+        if (d->pendingInterfaces == 0 && !d->ready) {
+            //Apply straight away so the player is fully populated when it's announced
+            applyPendingChanges();
+            d->ready = true;
+            emit ready();
+        }
+        watcher->deleteLater();
+    });
+}
+
+void MprisPlayer::setDbusProperty(QString interface, QString property, QVariant value) {
+    QDBusMessage message = QDBusMessage::createMethodCall(d->service, MPRIS_PATH, "org.freedesktop.DBus.Properties", "Set");
     message.setArguments({
-                             interface->interface(),
-                             remoteProperty
+                             interface,
+                             property,
+                             QVariant::fromValue(QDBusVariant(value))
                          });
-    QDBusMessage reply = interface->connection().call(message);
-//    QVariant propertyValue = interface->property(qPrintable(remoteProperty));
-    QVariant propertyValue = reply.arguments().first().value<QDBusVariant>().variant();
-    d->properties.insert(localProperty, propertyValue);
-    d->propertyMappings.insert(interface->interface() + "." + remoteProperty, localProperty);
+    QDBusConnection::sessionBus().asyncCall(message);
+}
+
+void MprisPlayer::callDbusMethod(QString interface, QString method, QVariantList arguments) {
+    QDBusMessage message = QDBusMessage::createMethodCall(d->service, MPRIS_PATH, interface, method);
+    message.setArguments(arguments);
+    QDBusConnection::sessionBus().asyncCall(message);
 }
 
 void MprisPlayer::dbusPropertyChanged(QString interfaceName, QMap<QString, QVariant> changedProperties, QStringList invalidatedProperties) {
     Q_UNUSED(invalidatedProperties)
-    for (QString property : changedProperties.keys()) {
-        if (!d->propertyMappings.contains(interfaceName + "." + property)) {
-            qDebug() << "MPRIS received unknown property change: " + interfaceName + "." + property;
-            continue;
+    if (changedProperties.isEmpty()) return;
+
+    bool applyScheduled = d->pendingChanges != 0;
+    for (auto i = changedProperties.constBegin(); i != changedProperties.constEnd(); i++) {
+        const PropertyHandler* handler = handlerFor(interfaceName, i.key());
+        if (handler == nullptr) continue; //Not a property we track (Position is never announced anyway)
+
+        //Only the latest value of each property survives until the changes are applied
+        d->pendingProperties[propertyIndex(handler->property)] = i.value();
+        d->pendingChanges |= handler->property;
+    }
+
+    //Coalesce everything that arrives during this event loop iteration into one update
+    if (!applyScheduled && d->pendingChanges != 0) QTimer::singleShot(0, this, &MprisPlayer::applyPendingChanges);
+}
+
+void MprisPlayer::applyPendingChanges() {
+    if (d->pendingChanges == 0) return; //Already applied
+
+    StateProperties pending = d->pendingChanges;
+    StateProperties changed;
+    d->pendingChanges = StateProperties();
+
+    //Capture where we are before the play state or rate changes how the position advances
+    qint64 currentPosition = position();
+
+    for (const PropertyHandler& handler : propertyHandlers) {
+        if (!pending.testFlag(handler.property)) continue;
+
+        int index = propertyIndex(handler.property);
+        QVariant value = d->pendingProperties[index];
+        d->pendingProperties[index].clear();
+
+        if (handler.property == MetadataProperty && value.userType() == qMetaTypeId<QDBusArgument>()) {
+            //Marshal the DBus argument into a metadata map once, rather than on every read
+            MetadataMap map;
+            value.value<QDBusArgument>() >> map;
+            value = map;
         }
 
-        QString localProperty = d->propertyMappings.value(interfaceName + "." + property);
-        d->properties.insert(localProperty, changedProperties.value(property));
-        QMetaObject::invokeMethod(this, qPrintable(localProperty + "Changed"), Qt::DirectConnection);
+        if (d->properties[index] == value) continue;
+        d->properties[index] = value;
+        changed |= handler.property;
     }
+
+    if (changed == 0) return;
+
+    if (changed.testFlag(MetadataProperty)) {
+        //New track; assume it starts from the beginning until the player tells us otherwise
+        updateKnownPosition(0);
+        fetchPosition();
+    } else if (changed.testFlag(PlaybackStatusProperty) || changed.testFlag(RateProperty)) {
+        updateKnownPosition(currentPosition);
+        fetchPosition();
+    }
+
+    if (changed.testFlag(PlaybackStatusProperty)) {
+        if (playbackStatus() == Playing) {
+            d->positionSyncTimer->start();
+        } else {
+            d->positionSyncTimer->stop();
+        }
+    }
+
+    //Only emit once every property has been updated so handlers see a consistent state
+    for (const PropertyHandler& handler : propertyHandlers) {
+        if (changed.testFlag(handler.property)) (this->*handler.changed)();
+    }
+    emit stateChanged(changed);
+}
+
+void MprisPlayer::fetchPosition() {
+    QDBusMessage message = QDBusMessage::createMethodCall(d->service, MPRIS_PATH, "org.freedesktop.DBus.Properties", "Get");
+    message.setArguments({MPRIS_PLAYER_INTERFACE, "Position"});
+
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+        if (!reply.isError()) {
+            //Our estimate may have drifted from what the player says, so let anyone showing it catch up
+            qint64 position = reply.value().variant().toLongLong();
+            updateKnownPosition(position);
+            emit positionResynced(position);
+        }
+        watcher->deleteLater();
+    });
+}
+
+void MprisPlayer::updateKnownPosition(qint64 position) {
+    d->knownPosition = position;
+    d->positionClock.start();
+}
+
+void MprisPlayer::dbusSeeked(qint64 position) {
+    updateKnownPosition(position);
+    emit seeked(position);
 }
 
 void MprisPlayer::serviceOwnerChanged(QString serviceName, QString oldOwner, QString newOwner)
 {
-    if (serviceName != d->interface->service()) return; //Not interested in this service
+    Q_UNUSED(newOwner)
+    if (serviceName != d->service) return; //Not interested in this service
     if (oldOwner != "") {
         //We're gone!
         emit gone();
@@ -111,100 +280,104 @@ void MprisPlayer::serviceOwnerChanged(QString serviceName, QString oldOwner, QSt
 }
 
 QString MprisPlayer::service() {
-    return d->interface->service();
+    return d->service;
+}
+
+bool MprisPlayer::isReady() {
+    return d->ready;
 }
 
 void MprisPlayer::raise() {
-    d->interface->asyncCall("Raise");
+    callDbusMethod(MPRIS_ROOT_INTERFACE, "Raise");
 }
 
 void MprisPlayer::quit() {
-    d->interface->asyncCall("Quit");
+    callDbusMethod(MPRIS_ROOT_INTERFACE, "Quit");
 }
 
 void MprisPlayer::next()
 {
-    d->player->asyncCall("Next");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Next");
 }
 
 void MprisPlayer::previous()
 {
-    d->player->asyncCall("Previous");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Previous");
 }
 
 void MprisPlayer::pause()
 {
-    d->player->asyncCall("Pause");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Pause");
 }
 
 void MprisPlayer::playPause()
 {
-    d->player->asyncCall("PlayPause");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "PlayPause");
 }
 
 void MprisPlayer::stop()
 {
-    d->player->asyncCall("Stop");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Stop");
 }
 
 void MprisPlayer::play()
 {
-    d->player->asyncCall("Play");
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Play");
 }
 
 void MprisPlayer::seek(qint64 offset)
 {
-    d->player->asyncCall("Seek", offset);
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "Seek", {offset});
 }
 
 void MprisPlayer::setPosition(qint64 position)
 {
-    d->player->asyncCall("SetPosition", metadata().value("mpris:trackid"), position);
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "SetPosition", {metadata().value("mpris:trackid"), position});
 }
 
 void MprisPlayer::openUri(QString uri)
 {
-    d->player->asyncCall(uri);
+    callDbusMethod(MPRIS_PLAYER_INTERFACE, "OpenUri", {uri});
 }
 
-QVariant MprisPlayer::privateProperty(QString name) {
-    return d->properties.value(name);
+QVariant MprisPlayer::privateProperty(StateProperty property) {
+    return d->properties[propertyIndex(property)];
 }
 
 QString MprisPlayer::identity() {
-    return privateProperty("identity").toString();
+    return privateProperty(IdentityProperty).toString();
 }
 
 bool MprisPlayer::canQuit() {
-    return privateProperty("canQuit").toBool();
+    return privateProperty(CanQuitProperty).toBool();
 }
 
 bool MprisPlayer::isFullscreen() {
-    return privateProperty("isFullscreen").toBool();
+    return privateProperty(IsFullscreenProperty).toBool();
 }
 
 bool MprisPlayer::canFullscreen() {
-    return privateProperty("canFullscreen").toBool();
+    return privateProperty(CanFullscreenProperty).toBool();
 }
 
 bool MprisPlayer::canRaise() {
-    return privateProperty("canRaise").toBool();
+    return privateProperty(CanRaiseProperty).toBool();
 }
 
 bool MprisPlayer::hasTrackList() {
-    return privateProperty("hasTrackList").toBool();
+    return privateProperty(HasTrackListProperty).toBool();
 }
 
 void MprisPlayer::setIsFullscreen(bool fullscreen) {
-    d->interface->setProperty("Fullscreen", fullscreen);
+    setDbusProperty(MPRIS_ROOT_INTERFACE, "Fullscreen", fullscreen);
 }
 
 QString MprisPlayer::desktopEntry() {
-    return privateProperty("desktopEntry").toString();
+    return privateProperty(DesktopEntryProperty).toString();
 }
 
 MprisPlayer::PlayingStatus MprisPlayer::playbackStatus() {
-    QString status = privateProperty("playbackStatus").toString();
+    QString status = privateProperty(PlaybackStatusProperty).toString();
     if (status == "Playing") {
         return Playing;
     } else if (status == "Paused") {
@@ -215,7 +388,7 @@ MprisPlayer::PlayingStatus MprisPlayer::playbackStatus() {
 }
 
 MprisPlayer::RepeatStatus MprisPlayer::repeating() {
-    QString repeating = privateProperty("repeating").toString();
+    QString repeating = privateProperty(RepeatingProperty).toString();
     if (repeating == "Track") {
         return RepeatOne;
     } else if (repeating == "Playlist") {
@@ -228,93 +401,93 @@ MprisPlayer::RepeatStatus MprisPlayer::repeating() {
 void MprisPlayer::setRepeating(RepeatStatus repeating) {
     switch (repeating) {
         case RepeatOne:
-            d->player->setProperty("LoopStatus", "Track");
+            setDbusProperty(MPRIS_PLAYER_INTERFACE, "LoopStatus", "Track");
             break;
         case RepeatAll:
-            d->player->setProperty("LoopStatus", "Playlist");
+            setDbusProperty(MPRIS_PLAYER_INTERFACE, "LoopStatus", "Playlist");
             break;
         case NoRepeat:
-            d->player->setProperty("LoopStatus", "None");
+            setDbusProperty(MPRIS_PLAYER_INTERFACE, "LoopStatus", "None");
     }
 }
 
 double MprisPlayer::rate() {
-    return privateProperty("rate").toDouble();
+    return privateProperty(RateProperty).toDouble();
 }
 
 void MprisPlayer::setRate(double rate) {
-    d->player->setProperty("Rate", rate);
+    setDbusProperty(MPRIS_PLAYER_INTERFACE, "Rate", rate);
 }
 
 bool MprisPlayer::shuffle() {
-    return privateProperty("shuffle").toBool();
+    return privateProperty(ShuffleProperty).toBool();
 }
 
 void MprisPlayer::setShuffle(bool shuffle) {
-    d->player->setProperty("Shuffle", shuffle);
+    setDbusProperty(MPRIS_PLAYER_INTERFACE, "Shuffle", shuffle);
 }
 
 MetadataMap MprisPlayer::metadata() {
-    QVariant v = privateProperty("metadata");
-    if (v.canConvert<MetadataMap>()) {
-        return v.value<MetadataMap>();
-    } else {
-        //Marshal the DBus argument into a metadata map before adding it into the properties
-        QDBusArgument arg = v.value<QDBusArgument>();
-        MetadataMap map;
-        arg >> map;
-        return map;
-    }
+    return privateProperty(MetadataProperty).value<MetadataMap>();
 }
 
 double MprisPlayer::volume() {
-    return privateProperty("volume").toDouble();
+    return privateProperty(VolumeProperty).toDouble();
 }
 
 void MprisPlayer::setVolume(double volume) {
-    d->player->setProperty("Volume", volume);
+    setDbusProperty(MPRIS_PLAYER_INTERFACE, "Volume", volume);
 }
 
 qint64 MprisPlayer::position() {
-    return d->player->property("Position").toInt();
+    qint64 position = d->knownPosition;
+    if (playbackStatus() == Playing && d->positionClock.isValid()) {
+        //Players that don't expose Rate play at normal speed
+        QVariant rate = privateProperty(RateProperty);
+        position += qRound64(d->positionClock.elapsed() * 1000 * (rate.isValid() ? rate.toDouble() : 1));
+    }
+
+    qint64 length = metadata().value("mpris:length").toLongLong();
+    if (length > 0 && position > length) position = length;
+    return qMax(position, static_cast<qint64>(0));
 }
 
 double MprisPlayer::minRate()
 {
-    return privateProperty("minRate").toDouble();
+    return privateProperty(MinRateProperty).toDouble();
 }
 
 double MprisPlayer::maxRate()
 {
-    return privateProperty("maxRate").toDouble();
+    return privateProperty(MaxRateProperty).toDouble();
 }
 
 bool MprisPlayer::canGoNext()
 {
-    return privateProperty("canGoNext").toBool();
+    return privateProperty(CanGoNextProperty).toBool();
 }
 
 bool MprisPlayer::canGoPrevious()
 {
-    return privateProperty("canGoPrevious").toBool();
+    return privateProperty(CanGoPreviousProperty).toBool();
 }
 
 bool MprisPlayer::canPlay()
 {
-    return privateProperty("canPlay").toBool();
+    return privateProperty(CanPlayProperty).toBool();
 }
 
 bool MprisPlayer::canPause()
 {
-    return privateProperty("canPause").toBool();
+    return privateProperty(CanPauseProperty).toBool();
 }
 
 bool MprisPlayer::canSeek()
 {
-    return privateProperty("canSeek").toBool();
+    return privateProperty(CanSeekProperty).toBool();
 }
 
 bool MprisPlayer::canControl()
 {
-    return d->player->property("CanControl").toBool();
+    return privateProperty(CanControlProperty).toBool();
 }
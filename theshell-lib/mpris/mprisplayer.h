@@ -28,7 +28,6 @@
 
 typedef QMap<QString, QVariant> MetadataMap;
 
-class QDBusInterface;
 struct MprisPlayerPrivate;
 class MprisPlayer : public QObject
 {
@@ -49,6 +48,31 @@ class MprisPlayer : public QObject
             RepeatAll
         };
 
+        enum StateProperty : quint32 {
+            CanQuitProperty = 0x1,
+            IsFullscreenProperty = 0x2,
+            CanFullscreenProperty = 0x4,
+            CanRaiseProperty = 0x8,
+            HasTrackListProperty = 0x10,
+            IdentityProperty = 0x20,
+            DesktopEntryProperty = 0x40,
+            PlaybackStatusProperty = 0x80,
+            RepeatingProperty = 0x100,
+            RateProperty = 0x200,
+            ShuffleProperty = 0x400,
+            MetadataProperty = 0x800,
+            VolumeProperty = 0x1000,
+            MinRateProperty = 0x2000,
+            MaxRateProperty = 0x4000,
+            CanGoNextProperty = 0x8000,
+            CanGoPreviousProperty = 0x10000,
+            CanPlayProperty = 0x20000,
+            CanPauseProperty = 0x40000,
+            CanSeekProperty = 0x80000,
+            CanControlProperty = 0x100000
+        };
+        Q_DECLARE_FLAGS(StateProperties, StateProperty)
+
         Q_PROPERTY(QString identity READ identity NOTIFY identityChanged)
         Q_PROPERTY(bool canQuit READ canQuit NOTIFY canQuitChanged)
         Q_PROPERTY(bool canFullscreen READ canFullscreen NOTIFY canFullscreenChanged)
@@ -59,6 +83,7 @@ class MprisPlayer : public QObject
 
         Q_PROPERTY(PlayingStatus playbackStatus READ playbackStatus NOTIFY playbackStatusChanged)
         Q_PROPERTY(RepeatStatus repeating READ repeating WRITE setRepeating NOTIFY repeatingChanged)
+        Q_PROPERTY(double rate READ rate WRITE setRate NOTIFY rateChanged)
         Q_PROPERTY(bool shuffle READ shuffle WRITE setShuffle NOTIFY shuffleChanged)
         Q_PROPERTY(MetadataMap metadata READ metadata NOTIFY metadataChanged)
         Q_PROPERTY(double volume READ volume WRITE setVolume NOTIFY volumeChanged)
@@ -71,6 +96,7 @@ class MprisPlayer : public QObject
         Q_PROPERTY(bool canSeek READ canSeek NOTIFY canSeekChanged)
 
         QString service();
+        bool isReady();
 
         QString identity();
         bool canQuit();
@@ -105,6 +131,9 @@ class MprisPlayer : public QObject
 
     signals:
         void seeked(qint64 position);
+        void positionResynced(qint64 position);
+        void stateChanged(MprisPlayer::StateProperties changed);
+
         void identityChanged();
         void canQuitChanged();
         void canFullscreenChanged();
@@ -115,6 +144,7 @@ class MprisPlayer : public QObject
 
         void playbackStatusChanged();
         void repeatingChanged();
+        void rateChanged();
         void shuffleChanged();
         void metadataChanged();
         void volumeChanged();
@@ -127,6 +157,7 @@ class MprisPlayer : public QObject
         void canSeekChanged();
         void canControlChanged();
 
+        void ready();
         void gone();
 
     public slots:
@@ -145,14 +176,21 @@ class MprisPlayer : public QObject
 
     private slots:
         void dbusPropertyChanged(QString interfaceName, QMap<QString, QVariant> changedProperties, QStringList invalidatedProperties);
+        void applyPendingChanges();
+        void fetchPosition();
+        void dbusSeeked(qint64 position);
         void serviceOwnerChanged(QString serviceName, QString oldOwner, QString newOwner);
 
     private:
         MprisPlayerPrivate* d;
 
-        void registerDbusProperty(QDBusInterface* interface, QString localProperty, QString remoteProperty);
-        QVariant privateProperty(QString name);
+        void fetchDbusProperties(QString interface);
+        void setDbusProperty(QString interface, QString property, QVariant value);
+        void updateKnownPosition(qint64 position);
+        void callDbusMethod(QString interface, QString method, QVariantList arguments = QVariantList());
+        QVariant privateProperty(StateProperty property);
 };
 typedef QSharedPointer<MprisPlayer> MprisPlayerPtr;
+Q_DECLARE_OPERATORS_FOR_FLAGS(MprisPlayer::StateProperties)
 
 #endif // MPRISPLAYER_H
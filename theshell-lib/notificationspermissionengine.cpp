@@ -19,102 +19,261 @@
  * *************************************/
 #include "notificationspermissionengine.h"
 
-#include "qsettingsformats.h"
 #include <QSettings>
-#include <QCryptographicHash>
 #include <QIcon>
 #include <QFile>
-#include <QDir>
-#include <QDirIterator>
-#include <QLocale>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QCoreApplication>
+#include <tpromise.h>
 #include "application.h"
 
+//Every engine shares this store so that checking a permission is a hash lookup.
+//Changes are written back on a worker thread, and edits made by other processes are picked up by a file watcher.
+struct NotificationsPermissionStore {
+    bool loaded = false;
+    QString settingsPath;
+    QDateTime settingsModified;
+    QFileSystemWatcher* watcher = nullptr;
+
+    QHash<QString, QVariantMap> groups;
+    QSet<QString> dirtyGroups;
+    QSet<QString> removedGroups;
+    bool flushPending = false;
+    bool writeInFlight = false;
+
+    //Desktop file lookups need a directory walk, so remember the results until the applications change
+    QHash<QString, bool> desktopFiles;
+    QHash<QString, QIcon> icons;
+    QHash<QString, QString> names;
+
+    void ensureLoaded();
+    void load();
+    void reloadIfChanged();
+    void scheduleFlush();
+    void flush(bool block = false);
+    bool desktopFileExists(QString desktopFile);
+};
+
+static NotificationsPermissionStore* store = new NotificationsPermissionStore();
+
+void NotificationsPermissionStore::ensureLoaded() {
+    if (loaded) return;
+    loaded = true;
+
+    load();
+
+    watcher = new QFileSystemWatcher();
+    watcher->addPath(QFileInfo(settingsPath).absolutePath());
+    if (QFile::exists(settingsPath)) watcher->addPath(settingsPath);
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, [=] {
+        reloadIfChanged();
+    });
+    QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, [=] {
+        reloadIfChanged();
+    });
+
+    QObject::connect(ApplicationDaemon::instance(), &ApplicationDaemon::appsUpdateRequired, [=] {
+        desktopFiles.clear();
+        icons.clear();
+        names.clear();
+    });
+
+    QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [=] {
+        if (flushPending) flush(true);
+    });
+}
+
+void NotificationsPermissionStore::load() {
+    QSettings appSettings("theSuite", "theShell-notifications");
+    settingsPath = appSettings.fileName();
+    settingsModified = QFileInfo(settingsPath).lastModified();
+
+    groups.clear();
+    for (QString group : appSettings.childGroups()) {
+        appSettings.beginGroup(group);
+        QVariantMap values;
+        for (QString key : appSettings.childKeys()) {
+            values.insert(key, appSettings.value(key));
+        }
+        groups.insert(group, values);
+        appSettings.endGroup();
+    }
+}
+
+void NotificationsPermissionStore::reloadIfChanged() {
+    //QSettings replaces the file when it saves, which drops it from the watcher
+    if (QFile::exists(settingsPath) && !watcher->files().contains(settingsPath)) watcher->addPath(settingsPath);
+
+    //Our own writes will be reconciled when they finish
+    if (flushPending || writeInFlight) return;
+
+    QDateTime modified = QFileInfo(settingsPath).lastModified();
+    if (modified == settingsModified) return;
+    load();
+}
+
+void NotificationsPermissionStore::scheduleFlush() {
+    if (flushPending) return;
+    flushPending = true;
+    QTimer::singleShot(500, watcher, [=] {
+        flush();
+    });
+}
+
+void NotificationsPermissionStore::flush(bool block) {
+    if (writeInFlight && !block) {
+        //Wait for the previous write so that the two don't race each other
+        QTimer::singleShot(500, watcher, [=] {
+            flush();
+        });
+        return;
+    }
+    flushPending = false;
+
+    QHash<QString, QVariantMap> changed;
+    for (QString group : dirtyGroups) {
+        if (groups.contains(group)) changed.insert(group, groups.value(group));
+    }
+    QSet<QString> removed = removedGroups;
+    dirtyGroups.clear();
+    removedGroups.clear();
+
+    auto write = [=] {
+        QSettings appSettings("theSuite", "theShell-notifications");
+        for (QString group : removed) {
+            appSettings.remove(group);
+        }
+        for (QString group : changed.keys()) {
+            appSettings.beginGroup(group);
+            QVariantMap values = changed.value(group);
+            for (QString key : values.keys()) {
+                appSettings.setValue(key, values.value(key));
+            }
+            appSettings.endGroup();
+        }
+        appSettings.sync();
+    };
+
+    if (block) {
+        write();
+        return;
+    }
+
+    writeInFlight = true;
+    (new tPromise<bool>([=](QString& error) -> bool {
+        Q_UNUSED(error)
+        write();
+        return true;
+    }))->then([=](bool) {
+        writeInFlight = false;
+        settingsModified = QFileInfo(settingsPath).lastModified();
+        if (QFile::exists(settingsPath) && !watcher->files().contains(settingsPath)) watcher->addPath(settingsPath);
+    });
+}
+
+bool NotificationsPermissionStore::desktopFileExists(QString desktopFile) {
+    if (desktopFiles.contains(desktopFile)) return desktopFiles.value(desktopFile);
+
+    bool exists;
+    if (groups.contains("dsk-" + desktopFile)) {
+        //We've seen this desktop file before
+        exists = true;
+    } else {
+        exists = Application(desktopFile).isValid();
+    }
+    desktopFiles.insert(desktopFile, exists);
+    return exists;
+}
+
 struct NotificationsPermissionEnginePrivate {
-    QScopedPointer<QSettings> appSettings;
+    QString groupName;
+    QString desktopFile;
     QScopedPointer<Application> desktopApp;
     bool isValidApp = true;
     bool istheshell = false;
+
+    Application* application() {
+        if (desktopApp.isNull()) desktopApp.reset(new Application(desktopFile));
+        return desktopApp.data();
+    }
+
+    QVariant value(QString key, QVariant defaultValue = QVariant()) {
+        return store->groups.value(groupName).value(key, defaultValue);
+    }
+
+    void setValue(QString key, QVariant value) {
+        store->groups[groupName].insert(key, value);
+        store->dirtyGroups.insert(groupName);
+        store->removedGroups.remove(groupName);
+        store->scheduleFlush();
+    }
 };
 
 NotificationsPermissionEngine::NotificationsPermissionEngine(QString appName, QString desktopFile)
 {
     d = new NotificationsPermissionEnginePrivate();
-    d->desktopApp.reset(new Application());
     d->isValidApp = true;
-    d->appSettings.reset(new QSettings("theSuite", "theShell-notifications"));
+    store->ensureLoaded();
 
     //Determine the name of the group used to store these settings
-    QString groupName;
+    bool isDesktopFile = false;
     if (desktopFile != "") {
-        //Search for desktop file
-        d->desktopApp.reset(new Application(desktopFile));
-
-        if (d->desktopApp->isValid()) {
+        if (store->desktopFileExists(desktopFile)) {
             //Desktop file was found, use desktop settings
-            groupName = "dsk-" + desktopFile;
+            d->groupName = "dsk-" + desktopFile;
+            d->desktopFile = desktopFile;
+            isDesktopFile = true;
         } else {
             //Desktop file not found, use app name settings
-            groupName = "app-" + appName;
+            d->groupName = "app-" + appName;
         }
     } else {
-        groupName = "app-" + appName;
+        d->groupName = "app-" + appName;
         if (appName == "theShell") {
             d->istheshell = true;
         }
     }
 
     //Check if notification settings for this app exist
-    if (!d->appSettings->childGroups().contains(groupName)) {
+    if (!store->groups.contains(d->groupName)) {
         //Notification settings don't exist, create them now
-        d->appSettings->beginGroup(groupName);
-        if (!d->desktopApp->isValid()) {
-            d->appSettings->setValue("isDesktopFile", false);
-            d->appSettings->setValue("identifier", appName);
-        } else {
-            d->appSettings->setValue("isDesktopFile", true);
-            d->appSettings->setValue("identifier", desktopFile);
-        }
-        d->appSettings->sync();
-    } else {
-        //Notification settings exist
-        d->appSettings->beginGroup(groupName);
+        d->setValue("isDesktopFile", isDesktopFile);
+        d->setValue("identifier", isDesktopFile ? desktopFile : appName);
     }
 }
 
 NotificationsPermissionEngine::NotificationsPermissionEngine() {
     d = new NotificationsPermissionEnginePrivate();
     d->isValidApp = false;
-    d->desktopApp.reset(new Application());
 }
 
 NotificationsPermissionEngine::~NotificationsPermissionEngine() {
-    d->appSettings->endGroup();
-    d->appSettings->deleteLater();
     delete d;
 }
 
 QStringList NotificationsPermissionEngine::knownApps() {
+    store->ensureLoaded();
+
     QStringList returnValue;
-    QSettings appSettings("theSuite", "theShell-notifications");
-    for (QString group : appSettings.childGroups()) {
-        appSettings.beginGroup(group);
-        if (appSettings.contains("identifier") && appSettings.value("isDesktopFile").toBool() == false && appSettings.value("identifier").toString() != "theShell") {
-            returnValue.append(appSettings.value("identifier").toString());
+    for (QVariantMap values : store->groups.values()) {
+        if (values.contains("identifier") && values.value("isDesktopFile").toBool() == false && values.value("identifier").toString() != "theShell") {
+            returnValue.append(values.value("identifier").toString());
         }
-        appSettings.endGroup();
     }
     return returnValue;
 }
 
 QStringList NotificationsPermissionEngine::knownDesktopFiles() {
+    store->ensureLoaded();
+
     QStringList returnValue;
-    QSettings appSettings("theSuite", "theShell-notifications");
-    for (QString group : appSettings.childGroups()) {
-        appSettings.beginGroup(group);
-        if (appSettings.contains("identifier") && appSettings.value("isDesktopFile").toBool() == true) {
-            returnValue.append(appSettings.value("identifier").toString());
+    for (QVariantMap values : store->groups.values()) {
+        if (values.contains("identifier") && values.value("isDesktopFile").toBool() == true) {
+            returnValue.append(values.value("identifier").toString());
         }
-        appSettings.endGroup();
     }
     return returnValue;
 }
@@ -125,87 +284,99 @@ bool NotificationsPermissionEngine::isValidApp() {
 
 bool NotificationsPermissionEngine::isDesktopFile() {
     if (!d->isValidApp) return false;
-    return d->appSettings->value("isDesktopFile", false).toBool();
+    return d->value("isDesktopFile", false).toBool();
 }
 
 QString NotificationsPermissionEngine::identifier() {
     if (!d->isValidApp) return "";
-    return d->appSettings->value("identifier").toString();
+    return d->value("identifier").toString();
 }
 
 QIcon NotificationsPermissionEngine::appIcon() {
     if (!d->isValidApp) return QIcon::fromTheme("generic-app");
     if (d->istheshell) return QIcon::fromTheme("theshell");
-    if (!d->desktopApp->isValid()) {
+    if (store->icons.contains(d->groupName)) return store->icons.value(d->groupName);
+
+    QIcon icon;
+    if (d->desktopFile == "" || !d->application()->isValid()) {
         if (QIcon::hasThemeIcon(identifier().toLower().replace(" ", "-"))) {
-           return QIcon::fromTheme(identifier().toLower().replace(" ", "-"));
+           icon = QIcon::fromTheme(identifier().toLower().replace(" ", "-"));
         } else if (QIcon::hasThemeIcon(identifier().toLower().replace(" ", ""))) {
-           return QIcon::fromTheme(identifier().toLower().replace(" ", ""));
+           icon = QIcon::fromTheme(identifier().toLower().replace(" ", ""));
         } else {
-            return QIcon::fromTheme("generic-app");
+            icon = QIcon::fromTheme("generic-app");
         }
     } else {
-         QString iconName = d->desktopApp->getProperty("Icon").toString();
+         QString iconName = d->application()->getProperty("Icon").toString();
          if (QFile(iconName).exists()) {
-             return QIcon(iconName);
+             icon = QIcon(iconName);
          } else {
-             return QIcon::fromTheme(iconName);
+             icon = QIcon::fromTheme(iconName);
          }
     }
+    store->icons.insert(d->groupName, icon);
+    return icon;
 }
 
 QString NotificationsPermissionEngine::appName() {
     if (!d->isValidApp) return "";
-    if (!d->desktopApp->isValid()) {
-        return identifier();
+    if (store->names.contains(d->groupName)) return store->names.value(d->groupName);
+
+    QString name;
+    if (d->desktopFile == "" || !d->application()->isValid()) {
+        name = identifier();
     } else {
-        return d->desktopApp->getProperty("Name").toString();
+        name = d->application()->getProperty("Name").toString();
     }
+    store->names.insert(d->groupName, name);
+    return name;
 }
 
 void NotificationsPermissionEngine::remove() {
     //Clear this app's settings
-    d->appSettings->remove("");
-    d->appSettings->sync();
+    store->groups.remove(d->groupName);
+    store->dirtyGroups.remove(d->groupName);
+    store->removedGroups.insert(d->groupName);
+    store->scheduleFlush();
     d->isValidApp = false;
 }
 
 void NotificationsPermissionEngine::setAllowNotifications(bool allowNotifications) {
     if (!d->isValidApp || d->istheshell) return;
-    d->appSettings->setValue("allow", allowNotifications);
+    d->setValue("allow", allowNotifications);
 }
 
 bool NotificationsPermissionEngine::allowNotifications() {
     if (!d->isValidApp) return false;
-    return d->appSettings->value("allow", true).toBool();
+    return d->value("allow", true).toBool();
 }
 
 void NotificationsPermissionEngine::setBypassesQuietMode(bool bypassesQuietMode) {
     if (!d->isValidApp || d->istheshell) return;
-    d->appSettings->setValue("bypassQuiet", bypassesQuietMode);
+    d->setValue("bypassQuiet", bypassesQuietMode);
 }
 
 bool NotificationsPermissionEngine::bypassesQuietMode() {
     if (!d->isValidApp) return false;
-    return d->appSettings->value("bypassQuiet", false).toBool();
+    return d->value("bypassQuiet", false).toBool();
 }
 
 void NotificationsPermissionEngine::setShowPopups(bool popups) {
     if (!d->isValidApp || d->istheshell) return;
-    d->appSettings->setValue("popup", popups);
+    d->setValue("popup", popups);
 }
 
 bool NotificationsPermissionEngine::showPopups() {
     if (!d->isValidApp) return false;
-    return d->appSettings->value("popup", true).toBool();
+    return d->value("popup", true).toBool();
 }
 
 void NotificationsPermissionEngine::setPlaySound(bool playSound) {
     if (!d->isValidApp || d->istheshell) return;
-    d->appSettings->setValue("sounds", playSound);
+    d->setValue("sounds", playSound);
 }
 
 bool NotificationsPermissionEngine::playSound() {
     if (!d->isValidApp) return false;
-    return d->appSettings->value("sounds", true).toBool();
+    return d->value("sounds", true).toBool();
 }
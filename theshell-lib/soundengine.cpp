@@ -20,42 +20,318 @@
 #include "soundengine.h"
 
 #include <QSettings>
-#include <QMediaPlayer>
 #include <QSoundEffect>
+#include <QAudioDecoder>
+#include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QCryptographicHash>
 #include <tsystemsound.h>
 
+#define MAXIMUM_IDLE_SOURCES 16
+
 struct SoundEnginePrivate {
-    QMediaPlayer* player;
+    QSoundEffect* effect = nullptr;
+    QUrl source;
+};
+
+struct SoundEnginePoolPrivate {
+    //Loaded sounds waiting to be played again, keyed by the WAV file they play
+    QHash<QUrl, QList<QSoundEffect*>> idle;
+
+    //Sources in idle, least recently used first
+    QList<QUrl> idleOrder;
+
+    //Sounds that we can stop, oldest first
+    QList<SoundEngine*> playing;
+
+    //Theme sound names that have already been looked up, keyed by theme and name
+    QHash<QString, QUrl> themeSounds;
+
+    //WAV copies of sounds QSoundEffect can't play itself, keyed by the original source
+    QHash<QUrl, QUrl> decoded;
+
+    //Sounds being decoded, and what to do with each once it's done
+    QHash<QUrl, QList<std::function<void(QUrl)>>> decoding;
 };
 
+struct SoundEngineDecodeJob {
+    QByteArray pcm;
+    QAudioFormat format;
+};
+
+SoundEnginePoolPrivate* SoundEngine::pool = new SoundEnginePoolPrivate();
+
 SoundEngine::SoundEngine(QObject *parent) : QObject(parent)
 {
     d = new SoundEnginePrivate();
 }
 
+SoundEngine::~SoundEngine() {
+    delete d;
+}
+
 SoundEngine* SoundEngine::play(QUrl path, qreal volume) {
+    //Make room by cutting off the oldest sound
+    QSettings settings;
+    int maximumSounds = qMax(1, settings.value("sound/maxSimultaneous", 4).toInt());
+    while (pool->playing.count() >= maximumSounds) {
+        finish(pool->playing.first());
+    }
+
     SoundEngine* engine = new SoundEngine();
+    pool->playing.append(engine);
 
-    QMediaPlayer* player = new QMediaPlayer(engine, QMediaPlayer::LowLatency);
-    player->setAudioRole(QAudio::NotificationRole);
-    player->setMedia(path);
-    player->setVolume(qRound(QAudio::convertVolume(volume, QAudio::LogarithmicVolumeScale, QAudio::LinearVolumeScale) * 100));
-    connect(player, &QMediaPlayer::stateChanged, engine, [=](QMediaPlayer::State state) {
-        if (state == QMediaPlayer::StoppedState) {
-            //We're done here
-            emit engine->done();
+    if (isWav(path)) {
+        start(engine, path, volume);
+        return engine;
+    }
 
-            player->deleteLater();
-            engine->deleteLater();
+    //QSoundEffect only handles WAV, so anything else is played from a WAV copy decoded the first time round
+    QPointer<SoundEngine> pending(engine);
+    decode(path, [=](QUrl wav) {
+        if (pending.isNull() || !pool->playing.contains(pending)) return; //Cut off before it was decoded
+
+        if (wav.isValid()) {
+            start(pending, wav, volume);
+        } else {
+            //Let the caller connect to done first
+            QTimer::singleShot(0, pending, [=] {
+                finish(pending);
+            });
         }
     });
-    player->play();
-
     return engine;
 }
 
+void SoundEngine::start(SoundEngine* engine, QUrl path, qreal volume) {
+    QSoundEffect* effect = takeIdle(path);
+    if (effect == nullptr) {
+        effect = new QSoundEffect();
+        effect->setSource(path);
+    }
+    engine->d->effect = effect;
+    engine->d->source = path;
+
+    effect->setVolume(QAudio::convertVolume(volume, QAudio::LogarithmicVolumeScale, QAudio::LinearVolumeScale));
+    connect(effect, &QSoundEffect::playingChanged, engine, [=] {
+        if (!effect->isPlaying()) finish(engine);
+    });
+
+    if (effect->status() == QSoundEffect::Ready) {
+        effect->play();
+    } else if (effect->status() == QSoundEffect::Error) {
+        //Let the caller connect to done first
+        QTimer::singleShot(0, engine, [=] {
+            finish(engine);
+        });
+    } else {
+        //This is the first time we've seen this sound; play it as soon as it's loaded
+        connect(effect, &QSoundEffect::statusChanged, engine, [=] {
+            if (effect->status() == QSoundEffect::Ready) {
+                effect->play();
+            } else if (effect->status() == QSoundEffect::Error) {
+                finish(engine);
+            }
+        });
+    }
+}
+
+bool SoundEngine::isWav(QUrl path) {
+    return path.path().endsWith(".wav", Qt::CaseInsensitive);
+}
+
+static bool writeWav(QString fileName, QAudioFormat format, const QByteArray& pcm) {
+    if (pcm.isEmpty() || format.sampleType() != QAudioFormat::SignedInt || format.byteOrder() != QAudioFormat::LittleEndian) return false;
+
+    QSaveFile file(fileName);
+    if (!file.open(QSaveFile::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("RIFF", 4);
+    stream << static_cast<quint32>(36 + pcm.size());
+    stream.writeRawData("WAVEfmt ", 8);
+    stream << static_cast<quint32>(16) << static_cast<quint16>(1) << static_cast<quint16>(format.channelCount());
+    stream << static_cast<quint32>(format.sampleRate()) << static_cast<quint32>(format.bytesForFrames(format.sampleRate()));
+    stream << static_cast<quint16>(format.bytesPerFrame()) << static_cast<quint16>(format.sampleSize());
+    stream.writeRawData("data", 4);
+    stream << static_cast<quint32>(pcm.size());
+    stream.writeRawData(pcm.constData(), pcm.size());
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+void SoundEngine::decode(QUrl path, std::function<void(QUrl)> callback) {
+    if (pool->decoded.contains(path)) {
+        callback(pool->decoded.value(path));
+        return;
+    }
+
+    //Everyone asking for the same sound while it's being decoded waits on the one decoder
+    bool decoding = pool->decoding.contains(path);
+    pool->decoding[path].append(callback);
+    if (decoding) return;
+
+    //Decoded copies are kept on disk, so a sound is only decoded again when it changes
+    QString cacheFile = decodedCacheFile(path);
+    if (QFile::exists(cacheFile)) {
+        finishDecoding(path, QUrl::fromLocalFile(cacheFile));
+        return;
+    }
+
+    //QSoundEffect plays 16 bit PCM
+    QAudioFormat format;
+    format.setCodec("audio/pcm");
+    format.setSampleRate(48000);
+    format.setChannelCount(2);
+    format.setSampleSize(16);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+
+    QAudioDecoder* decoder = new QAudioDecoder();
+    decoder->setAudioFormat(format);
+    if (path.scheme() == "qrc") {
+        QFile* file = new QFile(":" + path.path(), decoder);
+        file->open(QFile::ReadOnly);
+        decoder->setSourceDevice(file);
+    } else if (path.isLocalFile()) {
+        decoder->setSourceFilename(path.toLocalFile());
+    } else {
+        decoder->setSourceFilename(path.toString());
+    }
+
+    SoundEngineDecodeJob* job = new SoundEngineDecodeJob();
+    job->format = format;
+    connect(decoder, &QAudioDecoder::bufferReady, decoder, [=] {
+        QAudioBuffer buffer = decoder->read();
+        job->format = buffer.format();
+        job->pcm.append(buffer.constData<char>(), buffer.byteCount());
+    });
+    connect(decoder, &QAudioDecoder::finished, decoder, [=] {
+        decoder->disconnect();
+        decoder->deleteLater();
+
+        QUrl wav;
+        if (writeWav(cacheFile, job->format, job->pcm)) wav = QUrl::fromLocalFile(cacheFile);
+        delete job;
+        finishDecoding(path, wav);
+    });
+    connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), decoder, [=] {
+        decoder->disconnect();
+        decoder->deleteLater();
+
+        delete job;
+        finishDecoding(path, QUrl());
+    });
+    decoder->start();
+}
+
+void SoundEngine::finishDecoding(QUrl path, QUrl wav) {
+    //Failures aren't remembered so that the sound gets another go next time
+    if (wav.isValid()) pool->decoded.insert(path, wav);
+    for (std::function<void(QUrl)> callback : pool->decoding.take(path)) {
+        callback(wav);
+    }
+}
+
+QString SoundEngine::decodedCacheFile(QUrl path) {
+    //Local files can be replaced in place, so their modification time and size are part of the key
+    QString key = path.toString();
+    if (path.isLocalFile()) {
+        QFileInfo file(path.toLocalFile());
+        key += QString("@%1:%2").arg(file.lastModified().toMSecsSinceEpoch()).arg(file.size());
+    }
+
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/sounds");
+    if (!cacheDir.exists()) QDir::root().mkpath(cacheDir.absolutePath());
+    return cacheDir.absoluteFilePath(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex() + ".wav");
+}
+
+void SoundEngine::finish(SoundEngine* engine) {
+    if (!pool->playing.removeOne(engine)) return; //Already finished
+
+    QSoundEffect* effect = engine->d->effect;
+    engine->d->effect = nullptr;
+    if (effect != nullptr) {
+        effect->disconnect(engine);
+        if (effect->isPlaying()) effect->stop();
+
+        if (effect->status() == QSoundEffect::Error) {
+            effect->deleteLater();
+        } else {
+            returnIdle(engine->d->source, effect);
+        }
+    }
+
+    //We're done here
+    emit engine->done();
+    engine->deleteLater();
+}
+
+QSoundEffect* SoundEngine::takeIdle(QUrl path) {
+    if (!pool->idle.contains(path)) return nullptr;
+
+    QList<QSoundEffect*>& idle = pool->idle[path];
+    QSoundEffect* effect = idle.takeLast();
+    if (idle.isEmpty()) {
+        pool->idle.remove(path);
+        pool->idleOrder.removeOne(path);
+    } else {
+        pool->idleOrder.removeOne(path);
+        pool->idleOrder.append(path);
+    }
+    return effect;
+}
+
+void SoundEngine::returnIdle(QUrl path, QSoundEffect* effect) {
+    //Keep a couple of loaded copies of each sound around so the next play is instant
+    QList<QSoundEffect*>& idle = pool->idle[path];
+    if (idle.count() < 2) {
+        idle.append(effect);
+    } else {
+        effect->deleteLater();
+    }
+    pool->idleOrder.removeOne(path);
+    pool->idleOrder.append(path);
+
+    //Forget the sounds we haven't played in the longest time
+    while (pool->idleOrder.count() > MAXIMUM_IDLE_SOURCES) {
+        for (QSoundEffect* stale : pool->idle.take(pool->idleOrder.takeFirst())) {
+            stale->deleteLater();
+        }
+    }
+}
+
+void SoundEngine::preload(QUrl path) {
+    if (!isWav(path)) {
+        decode(path, [=](QUrl wav) {
+            if (wav.isValid()) preload(wav);
+        });
+        return;
+    }
+
+    if (pool->idle.contains(path)) return;
+
+    QSoundEffect* effect = new QSoundEffect();
+    effect->setSource(path);
+    returnIdle(path, effect);
+}
+
+void SoundEngine::preload(KnownSound sound) {
+    QUrl url = knownSoundUrl(sound);
+    if (url.isValid()) preload(url);
+}
+
 SoundEngine* SoundEngine::play(QString soundName, qreal volume) {
     //Play a sound from the audio theme
+    QUrl url = themeSoundUrl(soundName);
+    if (url.isValid()) return play(url, volume);
+
+    //We couldn't find the file ourselves, so let tSystemSound have a go
     tSystemSound* sound = tSystemSound::play(soundName, volume);
     if (sound == nullptr) {
         return nullptr;
@@ -70,17 +346,74 @@ SoundEngine* SoundEngine::play(QString soundName, qreal volume) {
     }
 }
 
+static QStringList themeList(QVariant value) {
+    //QSettings splits comma separated values into lists on its own
+    if (value.type() == QVariant::StringList) return value.toStringList();
+    return value.toString().split(",", QString::SkipEmptyParts);
+}
+
+QUrl SoundEngine::themeSoundUrl(QString soundName) {
+    QSettings platformSettings("theSuite", "ts-qtplatform");
+    QString theme = platformSettings.value("sound/theme", "Contemporary").toString();
+
+    QString key = theme + "/" + soundName;
+    if (pool->themeSounds.contains(key)) return pool->themeSounds.value(key);
+
+    //Find the folders of each theme, keyed by both folder name and the theme's display name
+    QHash<QString, QString> themeDirs;
+    QStringList searchPaths = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, "sounds", QStandardPaths::LocateDirectory);
+    for (QString searchPath : searchPaths) {
+        QDir dir(searchPath);
+        for (QString folderName : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            QString themeDir = dir.absoluteFilePath(folderName);
+            if (!QFile::exists(themeDir + "/index.theme")) continue;
+
+            QSettings themeFile(themeDir + "/index.theme", QSettings::IniFormat);
+            QString name = themeFile.value("Sound Theme/Name").toString();
+            if (!themeDirs.contains(folderName)) themeDirs.insert(folderName, themeDir);
+            if (!name.isEmpty() && !themeDirs.contains(name)) themeDirs.insert(name, themeDir);
+        }
+    }
+
+    //Look through the theme and what it inherits, then the fallback theme,
+    //trying less specific names (dialog-warning, then dialog) at each step
+    QStringList themes = {theme};
+    QUrl url;
+    for (QString name = soundName; !name.isEmpty() && !url.isValid(); name = name.contains("-") ? name.left(name.lastIndexOf("-")) : "") {
+        for (int i = 0; i < themes.count() && !url.isValid(); i++) {
+            QString themeDir = themeDirs.value(themes.at(i));
+            if (themeDir.isEmpty()) continue;
+
+            QSettings themeFile(themeDir + "/index.theme", QSettings::IniFormat);
+            QStringList directories = themeList(themeFile.value("Sound Theme/Directories", "stereo"));
+            for (QString directory : directories) {
+                for (QString extension : {"oga", "ogg", "wav"}) {
+                    QString file = QString("%1/%2/%3.%4").arg(themeDir, directory.trimmed(), name, extension);
+                    if (QFile::exists(file)) {
+                        url = QUrl::fromLocalFile(file);
+                        break;
+                    }
+                }
+                if (url.isValid()) break;
+            }
+
+            for (QString parent : themeList(themeFile.value("Sound Theme/Inherits"))) {
+                if (!themes.contains(parent.trimmed())) themes.append(parent.trimmed());
+            }
+            if (i == themes.count() - 1 && !themes.contains("freedesktop")) themes.append("freedesktop");
+        }
+    }
+
+    pool->themeSounds.insert(key, url);
+    return url;
+}
+
 SoundEngine* SoundEngine::play(KnownSound sound, qreal volume) {
-    QSettings settings;
     switch (sound) {
         case Notification: {
-            QString notificationSound = settings.value("notifications/sound", "tripleping").toString();
-            if (notificationSound == "tripleping") {
-                return play(QUrl("qrc:/sounds/notifications/tripleping.wav"), volume);
-            } else if (notificationSound == "upsidedown") {
-                return play(QUrl("qrc:/sounds/notifications/upsidedown.wav"), volume);
-            } else if (notificationSound == "echo") {
-                return play(QUrl("qrc:/sounds/notifications/echo.wav"), volume);
+            QUrl url = knownSoundUrl(sound);
+            if (url.isValid()) {
+                return play(url, volume);
             } else {
                 return nullptr;
             }
@@ -98,6 +431,33 @@ SoundEngine* SoundEngine::play(KnownSound sound, qreal volume) {
     return nullptr;
 }
 
+QUrl SoundEngine::knownSoundUrl(KnownSound sound) {
+    QSettings settings;
+    if (sound == Notification) {
+        QString notificationSound = settings.value("notifications/sound", "tripleping").toString();
+        if (notificationSound == "tripleping") {
+            return QUrl("qrc:/sounds/notifications/tripleping.wav");
+        } else if (notificationSound == "upsidedown") {
+            return QUrl("qrc:/sounds/notifications/upsidedown.wav");
+        } else if (notificationSound == "echo") {
+            return QUrl("qrc:/sounds/notifications/echo.wav");
+        }
+    }
+
+    switch (sound) {
+        case Volume:
+            return themeSoundUrl("audio-volume-change");
+        case Login:
+            return themeSoundUrl("desktop-login");
+        case Logout:
+            return themeSoundUrl("desktop-logout");
+        case Screenshot:
+            return themeSoundUrl("screen-capture");
+        default:
+            return QUrl();
+    }
+}
+
 SoundEngine* SoundEngine::playKnownSound(QString soundName, QString soundSetting, qreal volume) {
     if (tSystemSound::isSoundEnabled(soundSetting)) {
         return play(soundName, volume);
@@ -22,9 +22,12 @@
 
 #include <QObject>
 #include <QUrl>
+#include <functional>
 #include "debuginformationcollector.h"
 
+class QSoundEffect;
 struct SoundEnginePrivate;
+struct SoundEnginePoolPrivate;
 class SoundEngine : public QObject
 {
         Q_OBJECT
@@ -45,11 +48,26 @@ class SoundEngine : public QObject
         static SoundEngine* play(QUrl path, qreal volume = 1);
         static SoundEngine* play(KnownSound sound, qreal volume = 1);
 
+        static void preload(QUrl path);
+        static void preload(KnownSound sound);
+
     private:
         SoundEnginePrivate* d;
+        static SoundEnginePoolPrivate* pool;
 
         explicit SoundEngine(QObject *parent = T_QOBJECT_ROOT);
+        ~SoundEngine();
         static SoundEngine* playKnownSound(QString soundName, QString soundSetting, qreal volume = 1);
+        static void start(SoundEngine* engine, QUrl path, qreal volume);
+        static bool isWav(QUrl path);
+        static void decode(QUrl path, std::function<void(QUrl)> callback);
+        static void finishDecoding(QUrl path, QUrl wav);
+        static QString decodedCacheFile(QUrl path);
+        static QUrl knownSoundUrl(KnownSound sound);
+        static QUrl themeSoundUrl(QString soundName);
+        static void finish(SoundEngine* engine);
+        static QSoundEffect* takeIdle(QUrl path);
+        static void returnIdle(QUrl path, QSoundEffect* effect);
 };
 
 #endif // SOUNDENGINE_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui widgets multimedia thelib x11extras
+QT       += core gui widgets multimedia network thelib x11extras
 
 blueprint {
     TARGET = theshell-libb
@@ -30,16 +30,20 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    actiontracer.cpp \
     debuginformationcollector.cpp \
     globalkeyboard/globalkeyboardengine.cpp \
     globalkeyboard/shortcutinfodialog.cpp \
     hotkeyhud.cpp \
+    keyboardbacklightdaemon.cpp \
     locale/currentlocalesmodel.cpp \
     locale/localegroupmodel.cpp \
     locale/localemanager.cpp \
     locale/localemodel.cpp \
     locationdaemon.cpp \
+    mpris/albumartcache.cpp \
     mpris/mprisengine.cpp \
+    mpris/mprishub.cpp \
     mpris/mprisplayer.cpp \
         notificationspermissionengine.cpp \
     application.cpp \
@@ -49,16 +53,21 @@ SOURCES += \
     soundengine.cpp
 
 HEADERS += \
+        actiontracer.h \
         debuginformationcollector.h \
+        gestureactions.h \
         globalkeyboard/globalkeyboardengine.h \
         globalkeyboard/keyboardtables.h \
         globalkeyboard/shortcutinfodialog.h \
+        keyboardbacklightdaemon.h \
         locale/currentlocalesmodel.h \
         locale/localegroupmodel.h \
         locale/localemanager.h \
         locale/localemodel.h \
         locationdaemon.h \
+        mpris/albumartcache.h \
         mpris/mprisengine.h \
+        mpris/mprishub.h \
         mpris/mprisplayer.h \
         notificationspermissionengine.h \
         powerdaemon.h \
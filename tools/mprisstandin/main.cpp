@@ -0,0 +1,313 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+//A stand-in MPRIS player that takes its time answering, for checking that the shell never waits on players.
+//Signals go out straight away like a real player's would; only method replies are held back.
+//
+//  mprisstandin [--name <name>] [--delay <ms>] [--hang] [--track-interval <ms>] [--art <file>]
+//
+//  --name            registers as org.mpris.MediaPlayer2.<name> (default: standin)
+//  --delay           how long to wait before answering each method call (default: 5000)
+//  --hang            never answer method calls at all
+//  --track-interval  move on to another track this often (default: 15000, 0 to stay on one track)
+//  --art             cover art file; every track reuses this path with a different picture
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusVariant>
+#include <QDBusVirtualObject>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QImage>
+#include <QColor>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <QDir>
+
+#define MPRIS_PATH "/org/mpris/MediaPlayer2"
+#define MPRIS_ROOT_INTERFACE "org.mpris.MediaPlayer2"
+#define MPRIS_PLAYER_INTERFACE "org.mpris.MediaPlayer2.Player"
+#define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+
+class StandInPlayer : public QDBusVirtualObject
+{
+        Q_OBJECT
+
+    public:
+        StandInPlayer(QString name, int delay, bool hang, QString artFile, QObject* parent = nullptr);
+
+        QString introspect(const QString &path) const override;
+        bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+        void nextTrack(int direction = 1);
+
+    private:
+        QString name;
+        int delay;
+        bool hang;
+        QString artFile;
+        QTextStream out;
+
+        int track = 0;
+        QString playbackStatus = "Playing";
+        qint64 positionOffset = 0;
+        QElapsedTimer positionClock;
+        double volume = 1;
+
+        qint64 position();
+        QVariantMap properties(QString interface);
+        QVariantMap metadata();
+        void setPlaybackStatus(QString status);
+        void propertiesChanged(QString interface, QVariantMap changed);
+        QVariantList call(QString interface, QString method, QVariantList arguments, QString& error);
+};
+
+StandInPlayer::StandInPlayer(QString name, int delay, bool hang, QString artFile, QObject* parent) : QDBusVirtualObject(parent), out(stdout)
+{
+    this->name = name;
+    this->delay = delay;
+    this->hang = hang;
+    this->artFile = artFile;
+    positionClock.start();
+}
+
+QString StandInPlayer::introspect(const QString &path) const
+{
+    Q_UNUSED(path)
+
+    //Introspection can't be held back, but the shell doesn't introspect players any more anyway
+    return "  <interface name=\"" MPRIS_ROOT_INTERFACE "\"/>\n"
+           "  <interface name=\"" MPRIS_PLAYER_INTERFACE "\"/>\n";
+}
+
+bool StandInPlayer::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    if (message.type() != QDBusMessage::MethodCallMessage) return false;
+
+    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+    out << timestamp << " " << message.service() << " called " << message.interface() << "." << message.member() << "\n";
+    out.flush();
+
+    //Do what was asked now, and only hold back the answer
+    QString error;
+    QVariantList reply = call(message.interface(), message.member(), message.arguments(), error);
+
+    if (hang) return true;
+
+    QDBusMessage response = error.isEmpty() ? message.createReply(reply) : message.createErrorReply(QDBusError::UnknownMethod, error);
+    QDBusConnection replyConnection = connection;
+    QString member = message.member();
+    QTimer::singleShot(delay, this, [=]() mutable {
+        replyConnection.send(response);
+        out << QDateTime::currentDateTime().toString("hh:mm:ss.zzz") << " answered " << member << " after " << delay << "ms\n";
+        out.flush();
+    });
+    return true;
+}
+
+QVariantList StandInPlayer::call(QString interface, QString method, QVariantList arguments, QString& error)
+{
+    if (interface == PROPERTIES_INTERFACE) {
+        if (method == "GetAll" && arguments.count() == 1) {
+            return {properties(arguments.first().toString())};
+        } else if (method == "Get" && arguments.count() == 2) {
+            QVariantMap values = properties(arguments.first().toString());
+            QString property = arguments.at(1).toString();
+            if (values.contains(property)) return {QVariant::fromValue(QDBusVariant(values.value(property)))};
+            error = "No such property " + property;
+        } else if (method == "Set" && arguments.count() == 3) {
+            QVariant value = arguments.at(2).value<QDBusVariant>().variant();
+            if (arguments.at(1).toString() == "Volume") {
+                volume = value.toDouble();
+                propertiesChanged(MPRIS_PLAYER_INTERFACE, {{"Volume", volume}});
+            }
+            return {};
+        }
+    } else if (interface == MPRIS_PLAYER_INTERFACE || interface.isEmpty()) {
+        if (method == "PlayPause") {
+            setPlaybackStatus(playbackStatus == "Playing" ? "Paused" : "Playing");
+        } else if (method == "Play") {
+            setPlaybackStatus("Playing");
+        } else if (method == "Pause") {
+            setPlaybackStatus("Paused");
+        } else if (method == "Stop") {
+            setPlaybackStatus("Stopped");
+        } else if (method == "Next") {
+            nextTrack(1);
+        } else if (method == "Previous") {
+            nextTrack(-1);
+        } else if (method == "Seek" && arguments.count() == 1) {
+            positionOffset = qMax<qint64>(0, position() + arguments.first().toLongLong());
+            positionClock.restart();
+            QDBusConnection::sessionBus().send(QDBusMessage::createSignal(MPRIS_PATH, MPRIS_PLAYER_INTERFACE, "Seeked") << position());
+        } else if (method == "SetPosition" && arguments.count() == 2) {
+            positionOffset = arguments.at(1).toLongLong();
+            positionClock.restart();
+            QDBusConnection::sessionBus().send(QDBusMessage::createSignal(MPRIS_PATH, MPRIS_PLAYER_INTERFACE, "Seeked") << position());
+        } else {
+            error = "No such method " + method;
+        }
+        return {};
+    } else if (interface == MPRIS_ROOT_INTERFACE) {
+        if (method == "Quit") {
+            QTimer::singleShot(delay, QCoreApplication::instance(), &QCoreApplication::quit);
+        } else if (method != "Raise") {
+            error = "No such method " + method;
+        }
+        return {};
+    }
+
+    if (error.isEmpty()) error = "No such method " + interface + "." + method;
+    return {};
+}
+
+qint64 StandInPlayer::position()
+{
+    if (playbackStatus != "Playing") return positionOffset;
+    return positionOffset + positionClock.elapsed() * 1000;
+}
+
+QVariantMap StandInPlayer::properties(QString interface)
+{
+    if (interface == MPRIS_ROOT_INTERFACE) {
+        return {
+            {"CanQuit", true},
+            {"CanRaise", true},
+            {"Fullscreen", false},
+            {"CanSetFullscreen", false},
+            {"HasTrackList", false},
+            {"Identity", "Slow Stand-in Player (" + name + ")"},
+            {"DesktopEntry", ""}
+        };
+    } else if (interface == MPRIS_PLAYER_INTERFACE) {
+        return {
+            {"PlaybackStatus", playbackStatus},
+            {"LoopStatus", "None"},
+            {"Rate", 1.0},
+            {"Shuffle", false},
+            {"Metadata", metadata()},
+            {"Volume", volume},
+            {"Position", position()},
+            {"MinimumRate", 1.0},
+            {"MaximumRate", 1.0},
+            {"CanGoNext", true},
+            {"CanGoPrevious", true},
+            {"CanPlay", true},
+            {"CanPause", true},
+            {"CanSeek", true},
+            {"CanControl", true}
+        };
+    }
+    return {};
+}
+
+QVariantMap StandInPlayer::metadata()
+{
+    QVariantMap metadata;
+    metadata.insert("mpris:trackid", QVariant::fromValue(QDBusObjectPath(QString("/org/thesuite/standin/track/%1").arg(track))));
+    metadata.insert("mpris:length", static_cast<qint64>(180) * 1000000);
+    metadata.insert("xesam:title", QString("Track %1").arg(track + 1));
+    metadata.insert("xesam:album", "Waiting Room Classics");
+    metadata.insert("xesam:artist", QStringList({"The Stand-ins"}));
+    if (!artFile.isEmpty()) metadata.insert("mpris:artUrl", QUrl::fromLocalFile(artFile).toString());
+    return metadata;
+}
+
+void StandInPlayer::nextTrack(int direction)
+{
+    track = qMax(0, track + direction);
+    positionOffset = 0;
+    positionClock.restart();
+
+    if (!artFile.isEmpty()) {
+        //Same path, different picture, like players that serve their art through one temporary file
+        QImage art(256, 256, QImage::Format_RGB32);
+        art.fill(QColor::fromHsv((track * 67) % 360, 200, 220));
+        art.save(artFile, "PNG");
+    }
+
+    propertiesChanged(MPRIS_PLAYER_INTERFACE, {{"Metadata", metadata()}});
+    out << QDateTime::currentDateTime().toString("hh:mm:ss.zzz") << " now playing track " << track + 1 << "\n";
+    out.flush();
+}
+
+void StandInPlayer::setPlaybackStatus(QString status)
+{
+    positionOffset = position();
+    positionClock.restart();
+    playbackStatus = status;
+    propertiesChanged(MPRIS_PLAYER_INTERFACE, {{"PlaybackStatus", playbackStatus}});
+}
+
+void StandInPlayer::propertiesChanged(QString interface, QVariantMap changed)
+{
+    QDBusMessage signal = QDBusMessage::createSignal(MPRIS_PATH, PROPERTIES_INTERFACE, "PropertiesChanged");
+    signal.setArguments({interface, changed, QStringList()});
+    QDBusConnection::sessionBus().send(signal);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in MPRIS player that is slow to answer method calls");
+    parser.addHelpOption();
+    QCommandLineOption nameOption("name", "Register as org.mpris.MediaPlayer2.<name>.", "name", "standin");
+    QCommandLineOption delayOption("delay", "Wait this long before answering each method call.", "ms", "5000");
+    QCommandLineOption hangOption("hang", "Never answer method calls.");
+    QCommandLineOption trackOption("track-interval", "Move on to the next track this often; 0 to stay on one track.", "ms", "15000");
+    QCommandLineOption artOption("art", "Cover art file, rewritten with a different picture for every track.", "file", QDir::temp().filePath("mprisstandin-art.png"));
+    parser.addOptions({nameOption, delayOption, hangOption, trackOption, artOption});
+    parser.process(a);
+
+    StandInPlayer player(parser.value(nameOption), parser.value(delayOption).toInt(), parser.isSet(hangOption), parser.value(artOption));
+    player.nextTrack(0);
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerVirtualObject(MPRIS_PATH, &player)) {
+        QTextStream(stderr) << "Couldn't register " MPRIS_PATH "\n";
+        return 1;
+    }
+    QString service = "org.mpris.MediaPlayer2." + parser.value(nameOption);
+    if (!bus.registerService(service)) {
+        QTextStream(stderr) << "Couldn't register " << service << "\n";
+        return 1;
+    }
+    QTextStream(stdout) << "Registered " << service << "\n";
+
+    QTimer trackTimer;
+    int trackInterval = parser.value(trackOption).toInt();
+    if (trackInterval > 0) {
+        QObject::connect(&trackTimer, &QTimer::timeout, [&] {
+            player.nextTrack();
+        });
+        trackTimer.start(trackInterval);
+    }
+
+    return a.exec();
+}
+
+#include "main.moc"
@@ -0,0 +1,9 @@
+QT       += dbus gui
+CONFIG   += c++14 console
+CONFIG   -= app_bundle
+
+TARGET = mprisstandin
+TEMPLATE = app
+
+SOURCES += \
+    main.cpp
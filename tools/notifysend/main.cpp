@@ -0,0 +1,166 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+//Sends the kinds of notifications that use the popup's inline reply box and progress bar.
+//
+//  notifysend reply [--placeholder <text>]    ask for a reply and print whatever comes back
+//  notifysend progress [--step <n>] [--interval <ms>]
+//                                             count a progress bar up to 100% by replacing one notification
+//
+//Everything the server sends back (replies, actions, closes) is printed as it arrives.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QTextStream>
+#include <QTimer>
+
+#define NOTIFICATIONS_SERVICE "org.freedesktop.Notifications"
+#define NOTIFICATIONS_PATH "/org/freedesktop/Notifications"
+
+class NotificationListener : public QObject
+{
+        Q_OBJECT
+
+    public:
+        explicit NotificationListener(QObject* parent = nullptr) : QObject(parent), out(stdout) {
+            QDBusConnection bus = QDBusConnection::sessionBus();
+            bus.connect(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "NotificationReplied", this, SLOT(notificationReplied(uint,QString)));
+            bus.connect(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "ActionInvoked", this, SLOT(actionInvoked(uint,QString)));
+            bus.connect(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "NotificationClosed", this, SLOT(notificationClosed(uint,uint)));
+        }
+
+        uint notify(uint replaces, QString summary, QString body, QStringList actions, QVariantMap hints) {
+            QDBusMessage message = QDBusMessage::createMethodCall(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "Notify");
+            message.setArguments({"notifysend", replaces, "", summary, body, actions, hints, -1});
+
+            QElapsedTimer timer;
+            timer.start();
+            QDBusReply<uint> reply = QDBusConnection::sessionBus().call(message);
+            if (!reply.isValid()) {
+                log(QString("Notify failed: %1").arg(reply.error().message()));
+                return 0;
+            }
+            log(QString("Notify returned %1 after %2ms").arg(reply.value()).arg(timer.elapsed()));
+            ids.append(reply.value());
+            return reply.value();
+        }
+
+        QList<uint> ids;
+
+    signals:
+        void replied(uint id, QString text);
+        void closed(uint id);
+
+    private slots:
+        void notificationReplied(uint id, QString text) {
+            if (!ids.contains(id)) return;
+            log(QString("%1 replied: %2").arg(id).arg(text));
+            emit replied(id, text);
+        }
+
+        void actionInvoked(uint id, QString key) {
+            if (!ids.contains(id)) return;
+            log(QString("%1 action invoked: %2").arg(id).arg(key));
+        }
+
+        void notificationClosed(uint id, uint reason) {
+            if (!ids.contains(id)) return;
+            log(QString("%1 closed with reason %2").arg(id).arg(reason));
+            emit closed(id);
+        }
+
+    private:
+        QTextStream out;
+
+        void log(QString text) {
+            out << QDateTime::currentDateTime().toString("hh:mm:ss.zzz") << " " << text << "\n";
+            out.flush();
+        }
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Send notifications with inline replies or progress");
+    parser.addHelpOption();
+    parser.addPositionalArgument("mode", "reply or progress");
+    QCommandLineOption placeholderOption("placeholder", "Placeholder text for the reply box.", "text", "Type a reply to notifysend");
+    QCommandLineOption stepOption("step", "How far the progress bar moves each update.", "percent", "5");
+    QCommandLineOption intervalOption("interval", "Time between progress updates.", "ms", "250");
+    parser.addOptions({placeholderOption, stepOption, intervalOption});
+    parser.process(a);
+
+    QString mode = parser.positionalArguments().value(0);
+    NotificationListener listener;
+
+    if (mode == "reply") {
+        QVariantMap hints;
+        hints.insert("x-kde-reply-placeholder-text", parser.value(placeholderOption));
+        uint id = listener.notify(0, "Reply test", "Reply to this notification from its popup.", {"inline-reply", "Reply"}, hints);
+        if (id == 0) return 1;
+
+        //Closing the notification without replying ends the test
+        QMetaObject::Connection quitOnClose = QObject::connect(&listener, &NotificationListener::closed, &a, &QCoreApplication::quit);
+        QObject::connect(&listener, &NotificationListener::replied, &a, [&](uint repliedId, QString text) {
+            Q_UNUSED(repliedId)
+
+            //The server closes the notification once it's been replied to, so answer with a new one
+            //and stay around long enough to see it
+            QObject::disconnect(quitOnClose);
+            listener.notify(0, "Reply test", QString("You replied \"%1\"").arg(text), QStringList(), QVariantMap());
+            QTimer::singleShot(1000, &a, &QCoreApplication::quit);
+        });
+    } else if (mode == "progress") {
+        int step = qBound(1, parser.value(stepOption).toInt(), 100);
+        int value = 0;
+        uint id = listener.notify(0, "Progress test", "Working...", QStringList(), {{"value", value}});
+        if (id == 0) return 1;
+
+        QTimer* timer = new QTimer(&a);
+        timer->setInterval(parser.value(intervalOption).toInt());
+        QObject::connect(timer, &QTimer::timeout, &a, [&listener, &a, timer, id, step, value]() mutable {
+            value = qMin(100, value + step);
+            if (value < 100) {
+                //Each update replaces the notification and should only move the bar
+                listener.notify(id, "Progress test", QString("Working... %1%").arg(value), QStringList(), {{"value", value}});
+            } else {
+                //Dropping the value hint makes the last update a normal notification again
+                timer->stop();
+                listener.notify(id, "Progress test", "Done", QStringList(), QVariantMap());
+                QTimer::singleShot(1000, &a, &QCoreApplication::quit);
+            }
+        });
+        QObject::connect(&listener, &NotificationListener::closed, &a, &QCoreApplication::quit);
+        timer->start();
+    } else {
+        parser.showHelp(1);
+    }
+
+    return a.exec();
+}
+
+#include "main.moc"
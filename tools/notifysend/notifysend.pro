@@ -0,0 +1,10 @@
+QT       += dbus
+QT       -= gui
+CONFIG   += c++14 console
+CONFIG   -= app_bundle
+
+TARGET = notifysend
+TEMPLATE = app
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,172 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+//Floods the notification server with Notify calls and checks that it stays responsive meanwhile.
+//
+//  notifystress [--count <n>] [--rate <n>] [--in-flight <n>] [--probe <ms>] [--app <name>] [--close]
+//
+//While the flood runs, GetServerInformation is called every --probe ms. It's answered on the same
+//event loop as Notify, so its round trip shows how long anything else would have waited on the server.
+//Notify calls past the flood limit should be folded into one summary, which shows up as many calls
+//returning the same id.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QTimer>
+#include <QSet>
+#include <algorithm>
+#include <functional>
+
+#define NOTIFICATIONS_SERVICE "org.freedesktop.Notifications"
+#define NOTIFICATIONS_PATH "/org/freedesktop/Notifications"
+
+struct Latencies {
+    QList<qint64> samples;
+    int errors = 0;
+
+    QString report() {
+        if (samples.isEmpty()) return QString("no replies, %1 errors").arg(errors);
+
+        QList<qint64> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [=](int p) {
+            return sorted.at(qMin(sorted.count() - 1, sorted.count() * p / 100)) / 1000.0;
+        };
+        return QString("%1 replies, %2 errors; median %3ms, p99 %4ms, max %5ms")
+                .arg(sorted.count()).arg(errors)
+                .arg(percentile(50), 0, 'f', 2).arg(percentile(99), 0, 'f', 2).arg(sorted.last() / 1000.0, 0, 'f', 2);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Flood the notification server and measure how responsive it stays");
+    parser.addHelpOption();
+    QCommandLineOption countOption("count", "Send this many notifications.", "n", "2000");
+    QCommandLineOption rateOption("rate", "Notifications per second; 0 sends as fast as replies come back.", "n", "0");
+    QCommandLineOption inFlightOption("in-flight", "Calls allowed to wait for a reply at once.", "n", "32");
+    QCommandLineOption probeOption("probe", "How often to check the server's responsiveness.", "ms", "50");
+    QCommandLineOption appOption("app", "Application name to send as.", "name", "notifystress");
+    QCommandLineOption closeOption("close", "Close the notifications that were shown afterwards.");
+    parser.addOptions({countOption, rateOption, inFlightOption, probeOption, appOption, closeOption});
+    parser.process(a);
+
+    int count = qMax(1, parser.value(countOption).toInt());
+    int rate = parser.value(rateOption).toInt();
+    int maximumInFlight = qMax(1, parser.value(inFlightOption).toInt());
+    QString app = parser.value(appOption);
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    QTextStream out(stdout);
+
+    int sent = 0, inFlight = 0;
+    Latencies notifyLatency, probeLatency;
+    QSet<uint> ids;
+    QElapsedTimer runClock;
+    runClock.start();
+
+    QTimer floodTimer, probeTimer;
+    std::function<void()> finishIfDone;
+
+    auto send = [&] {
+        while (sent < count && inFlight < maximumInFlight) {
+            QDBusMessage message = QDBusMessage::createMethodCall(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "Notify");
+            message.setArguments({app, 0u, "", QString("Stress notification %1").arg(sent + 1), "Sent by notifystress", QStringList(), QVariantMap(), -1});
+
+            QElapsedTimer* callClock = new QElapsedTimer();
+            callClock->start();
+            QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(bus.asyncCall(message), &a);
+            QObject::connect(watcher, &QDBusPendingCallWatcher::finished, &a, [&, watcher, callClock] {
+                QDBusPendingReply<uint> reply = *watcher;
+                if (reply.isError()) {
+                    notifyLatency.errors++;
+                } else {
+                    notifyLatency.samples.append(callClock->nsecsElapsed() / 1000);
+                    ids.insert(reply.value());
+                }
+                delete callClock;
+                watcher->deleteLater();
+
+                inFlight--;
+                finishIfDone();
+            });
+
+            sent++;
+            inFlight++;
+            if (rate > 0) break;
+        }
+    };
+
+    finishIfDone = [&] {
+        if (rate == 0) send();
+        if (sent < count || inFlight > 0) return;
+
+        floodTimer.stop();
+        probeTimer.stop();
+
+        out << "Sent " << sent << " notifications in " << runClock.elapsed() << "ms\n";
+        out << "Notify:                " << notifyLatency.report() << "\n";
+        out << "GetServerInformation:  " << probeLatency.report() << "\n";
+        out << ids.count() << " distinct ids returned\n";
+        out.flush();
+
+        if (parser.isSet(closeOption)) {
+            for (uint id : ids) {
+                bus.call(QDBusMessage::createMethodCall(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "CloseNotification") << id);
+            }
+        }
+        a.quit();
+    };
+
+    QObject::connect(&probeTimer, &QTimer::timeout, &a, [&] {
+        QElapsedTimer* callClock = new QElapsedTimer();
+        callClock->start();
+        QDBusMessage message = QDBusMessage::createMethodCall(NOTIFICATIONS_SERVICE, NOTIFICATIONS_PATH, NOTIFICATIONS_SERVICE, "GetServerInformation");
+        QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(bus.asyncCall(message), &a);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, &a, [&, watcher, callClock] {
+            if (watcher->isError()) {
+                probeLatency.errors++;
+            } else {
+                probeLatency.samples.append(callClock->nsecsElapsed() / 1000);
+            }
+            delete callClock;
+            watcher->deleteLater();
+        });
+    });
+    probeTimer.start(qMax(1, parser.value(probeOption).toInt()));
+
+    if (rate > 0) {
+        QObject::connect(&floodTimer, &QTimer::timeout, &a, send);
+        floodTimer.start(qMax(1, 1000 / rate));
+    } else {
+        QTimer::singleShot(0, &a, send);
+    }
+
+    return a.exec();
+}
@@ -0,0 +1,165 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+//Times SoundEngine playing the same sounds over and over, the way notifications and volume feedback do.
+//
+//  soundbench [--passes <n>] [--sources <n>] [sound...]
+//
+//Each sound is a file, a URL or a sound theme name such as audio-volume-change; with none given,
+//generated tones are used. The first play of a sound loads it, decoding it to a cached WAV copy if it
+//isn't WAV already, and the rest should come from the pool, so the report shows the first play next to
+//the median of the others. Clear ~/.cache/theSuite/theShell/sounds to time a first decode again. Afterwards --sources distinct
+//tones are played once each to push the first ones out of the pool again.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QDataStream>
+#include <QTextStream>
+#include <QFile>
+#include <QTimer>
+#include <QtMath>
+#include <algorithm>
+#include <soundengine.h>
+
+struct Sample {
+    bool played = false;
+    qint64 callNs = 0;
+    qint64 doneMs = 0;
+};
+
+static Sample playOnce(QString sound) {
+    Sample sample;
+
+    QElapsedTimer timer;
+    timer.start();
+    SoundEngine* engine;
+    if (sound.contains("/")) {
+        engine = SoundEngine::play(QUrl::fromUserInput(sound));
+    } else {
+        engine = SoundEngine::play(sound);
+    }
+    sample.callNs = timer.nsecsElapsed();
+    if (engine == nullptr) return sample;
+
+    QEventLoop loop;
+    QObject::connect(engine, &SoundEngine::done, &loop, &QEventLoop::quit);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    sample.played = true;
+    sample.doneMs = timer.elapsed();
+    return sample;
+}
+
+static qint64 median(QList<qint64> values) {
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values.at(values.count() / 2);
+}
+
+static QString writeTone(QString path, int frequency) {
+    //150ms of 16 bit mono PCM
+    const int sampleRate = 44100;
+    const int samples = sampleRate * 15 / 100;
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly)) return "";
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("RIFF", 4);
+    stream << static_cast<quint32>(36 + samples * 2);
+    stream.writeRawData("WAVEfmt ", 8);
+    stream << static_cast<quint32>(16) << static_cast<quint16>(1) << static_cast<quint16>(1);
+    stream << static_cast<quint32>(sampleRate) << static_cast<quint32>(sampleRate * 2);
+    stream << static_cast<quint16>(2) << static_cast<quint16>(16);
+    stream.writeRawData("data", 4);
+    stream << static_cast<quint32>(samples * 2);
+    for (int i = 0; i < samples; i++) {
+        stream << static_cast<qint16>(qSin(2 * M_PI * frequency * i / sampleRate) * 8000);
+    }
+    return path;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setOrganizationName("theSuite");
+    a.setApplicationName("theShell");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Time repeated SoundEngine plays");
+    parser.addHelpOption();
+    QCommandLineOption passesOption("passes", "Play each sound this many times.", "n", "10");
+    QCommandLineOption sourcesOption("sources", "Distinct tones to play afterwards to cycle the pool.", "n", "24");
+    parser.addOptions({passesOption, sourcesOption});
+    parser.addPositionalArgument("sound", "Files, URLs or sound theme names to play.", "[sound...]");
+    parser.process(a);
+
+    QTextStream out(stdout);
+    QTemporaryDir toneDir;
+    int passes = qMax(2, parser.value(passesOption).toInt());
+    int sources = qMax(0, parser.value(sourcesOption).toInt());
+
+    QStringList sounds = parser.positionalArguments();
+    if (sounds.isEmpty()) sounds.append(writeTone(toneDir.filePath("tone.wav"), 880));
+
+    out << "sound                                  first call   first done   median call  median done\n";
+    for (QString sound : sounds) {
+        Sample first = playOnce(sound);
+        if (!first.played) {
+            out << sound << ": couldn't be played\n";
+            continue;
+        }
+
+        QList<qint64> calls, dones;
+        for (int i = 1; i < passes; i++) {
+            Sample sample = playOnce(sound);
+            if (!sample.played) continue;
+            calls.append(sample.callNs);
+            dones.append(sample.doneMs);
+        }
+
+        out << QString("%1 %2us %3ms %4us %5ms\n").arg(sound.right(38), -38)
+               .arg(first.callNs / 1000, 10).arg(first.doneMs, 10)
+               .arg(median(calls) / 1000, 10).arg(median(dones), 10);
+        out.flush();
+    }
+
+    if (sources > 0) {
+        //Play enough different sounds that the earliest ones are dropped from the pool
+        QStringList tones;
+        for (int i = 0; i < sources; i++) {
+            tones.append(writeTone(toneDir.filePath(QString("tone-%1.wav").arg(i)), 440 + i * 20));
+            playOnce(tones.last());
+        }
+
+        Sample oldest = playOnce(tones.first());
+        Sample newest = playOnce(tones.last());
+        out << "\n" << sources << " distinct sounds played\n";
+        out << QString("least recently played: %1us call, %2ms done\n").arg(oldest.callNs / 1000).arg(oldest.doneMs);
+        out << QString("most recently played:  %1us call, %2ms done\n").arg(newest.callNs / 1000).arg(newest.doneMs);
+    }
+
+    return 0;
+}
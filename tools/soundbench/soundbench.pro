@@ -0,0 +1,23 @@
+QT       += multimedia
+CONFIG   += c++14 console
+CONFIG   -= app_bundle
+
+TARGET = soundbench
+TEMPLATE = app
+
+LIBS += -L$$OUT_PWD/../../theshell-lib/
+INCLUDEPATH += $$PWD/../../theshell-lib
+DEPENDPATH += $$PWD/../../theshell-lib
+
+unix {
+    QT += thelib
+}
+
+blueprint {
+    LIBS += -ltheshell-libb
+} else {
+    LIBS += -ltheshell-lib
+}
+
+SOURCES += \
+    main.cpp
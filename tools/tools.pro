@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    mprisstandin \
+    notifysend \
+    notifystress \
+    soundbench \
+    xi2bench
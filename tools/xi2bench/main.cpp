@@ -0,0 +1,463 @@
+/****************************************
+ *
+ *   theShell - Desktop Environment
+ *   Copyright (C) 2019 Victor Tran
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *************************************/
+
+//Times the XI2 path of the shell's native event filter over a captured event stream.
+//
+//  xi2bench record <file> [seconds]     capture raw touch and motion events from the X server
+//  xi2bench synthesize <file> [events]  write a stream of motion events with touch swipes mixed in
+//  xi2bench replay <file> [passes]      replay a stream and report the cost per event
+//
+//Replay runs the decoding and gesture recognition the filter does for every event, and the
+//memmove based decoding the filter used before, so the two can be compared on the same stream.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDataStream>
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include <poll.h>
+
+#include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include "xi2wire.h"
+#include "gestures/gesturerecognizer.h"
+
+static const quint32 FileMagic = 0x58493242; //XI2B
+static const quint32 FileVersion = 1;
+
+struct EventStream {
+    int xiOpcode = 0;
+
+    //Each event is in its own buffer laid out the way xcb delivers it, full_sequence and all
+    std::vector<xcb_generic_event_t*> events;
+
+    ~EventStream() {
+        for (xcb_generic_event_t* event : events) free(event);
+    }
+
+    static quint32 eventSize(xcb_generic_event_t* event) {
+        if ((event->response_type & 0x7f) == XCB_GE_GENERIC) {
+            return 36 + reinterpret_cast<xcb_ge_generic_event_t*>(event)->length * 4;
+        }
+        return 36;
+    }
+
+    bool save(QString fileName) {
+        QFile file(fileName);
+        if (!file.open(QFile::WriteOnly)) return false;
+
+        QDataStream stream(&file);
+        stream << FileMagic << FileVersion << static_cast<qint32>(xiOpcode) << static_cast<quint32>(events.size());
+        for (xcb_generic_event_t* event : events) {
+            quint32 size = eventSize(event);
+            stream << size;
+            stream.writeRawData(reinterpret_cast<char*>(event), static_cast<int>(size));
+        }
+        return stream.status() == QDataStream::Ok;
+    }
+
+    bool load(QString fileName) {
+        QFile file(fileName);
+        if (!file.open(QFile::ReadOnly)) return false;
+
+        QDataStream stream(&file);
+        quint32 magic, version, count;
+        qint32 opcode;
+        stream >> magic >> version >> opcode >> count;
+        if (magic != FileMagic || version != FileVersion) return false;
+        xiOpcode = opcode;
+
+        for (quint32 i = 0; i < count; i++) {
+            quint32 size;
+            stream >> size;
+            if (size < 36 || size > 65536) return false;
+
+            xcb_generic_event_t* event = static_cast<xcb_generic_event_t*>(malloc(size));
+            stream.readRawData(reinterpret_cast<char*>(event), static_cast<int>(size));
+            events.push_back(event);
+        }
+        return stream.status() == QDataStream::Ok;
+    }
+};
+
+//Builds events the way xcb would hand them to us
+struct EventBuilder {
+    int xiOpcode;
+    quint16 sequence = 0;
+
+    xcb_generic_event_t* build(const char* wire, int wireSize) {
+        xcb_generic_event_t* event = static_cast<xcb_generic_event_t*>(calloc(1, static_cast<size_t>(wireSize + 4)));
+        memcpy(event, wire, 32);
+        memcpy(reinterpret_cast<char*>(event) + 36, wire + 32, static_cast<size_t>(wireSize - 32));
+        return event;
+    }
+
+    static FP3232 toFP3232(qreal value) {
+        FP3232 fixed;
+        fixed.integral = static_cast<INT32>(qFloor(value));
+        fixed.frac = static_cast<CARD32>((value - qFloor(value)) * 4294967296.0);
+        return fixed;
+    }
+
+    xcb_generic_event_t* deviceEvent(int type, quint32 detail, quint32 time, qreal x, qreal y) {
+        //Fixed part, an empty button mask and the X and Y valuators
+        char wire[sizeof(xXIDeviceEvent) + 4 + 2 * sizeof(FP3232)] = {};
+        xXIDeviceEvent* event = reinterpret_cast<xXIDeviceEvent*>(wire);
+        event->type = XCB_GE_GENERIC;
+        event->extension = static_cast<CARD8>(xiOpcode);
+        event->sequenceNumber = sequence++;
+        event->length = (sizeof(wire) - 32) / 4;
+        event->evtype = static_cast<CARD16>(type);
+        event->deviceid = 2;
+        event->sourceid = 10;
+        event->time = time;
+        event->detail = detail;
+        event->root_x = event->event_x = static_cast<FP1616>(x * 65536);
+        event->root_y = event->event_y = static_cast<FP1616>(y * 65536);
+        event->buttons_len = 0;
+        event->valuators_len = 1;
+
+        unsigned char* mask = reinterpret_cast<unsigned char*>(wire + sizeof(xXIDeviceEvent));
+        XISetMask(mask, 0);
+        XISetMask(mask, 1);
+        FP3232* values = reinterpret_cast<FP3232*>(mask + 4);
+        values[0] = toFP3232(x);
+        values[1] = toFP3232(y);
+        return build(wire, sizeof(wire));
+    }
+
+    xcb_generic_event_t* rawEvent(int type, quint32 detail, quint32 time, qreal x, qreal y) {
+        //Fixed part, the valuator mask, then the transformed and raw X and Y values
+        char wire[sizeof(xXIRawEvent) + 4 + 4 * sizeof(FP3232)] = {};
+        xXIRawEvent* event = reinterpret_cast<xXIRawEvent*>(wire);
+        event->type = XCB_GE_GENERIC;
+        event->extension = static_cast<CARD8>(xiOpcode);
+        event->sequenceNumber = sequence++;
+        event->length = (sizeof(wire) - 32) / 4;
+        event->evtype = static_cast<CARD16>(type);
+        event->deviceid = 2;
+        event->sourceid = 10;
+        event->time = time;
+        event->detail = detail;
+        event->valuators_len = 1;
+
+        unsigned char* mask = reinterpret_cast<unsigned char*>(wire + sizeof(xXIRawEvent));
+        if (type != XI_RawTouchEnd) {
+            XISetMask(mask, 0);
+            XISetMask(mask, 1);
+        }
+        FP3232* values = reinterpret_cast<FP3232*>(mask + 4);
+        values[0] = values[2] = toFP3232(x);
+        values[1] = values[3] = toFP3232(y);
+        return build(wire, sizeof(wire));
+    }
+};
+
+//What the filter does with the XI2 events it selected, minus the calls into the rest of the shell.
+//The drop and decode decisions are the shell's own, from xiHandleTouchEvent.
+struct CurrentFilter {
+    int xiOpcode;
+    quint64 xiEvents = xiTouchEvents();
+    QRectF range;
+    QRectF screenGeometry = QRectF(0, 0, 1920, 1080);
+    GestureRecognizer gestures;
+    QHash<uint32_t, QPointF> firstTouchPoints;
+    quint32 lastTouchTime = 0;
+    int gesturesFinished = 0;
+
+    CurrentFilter(int opcode, QRectF range) : xiOpcode(opcode), range(range) {
+        gestures.setScreenGeometry(screenGeometry);
+        QObject::connect(&gestures, &GestureRecognizer::gestureFinished, [=] {
+            gesturesFinished++;
+        });
+    }
+
+    void handle(xcb_generic_event_t* event) {
+        if ((event->response_type & 0x7f) != XCB_GE_GENERIC) return;
+        xiHandleTouchEvent(event, xiOpcode, xiEvents, *this);
+    }
+
+    void touchBegin(const xXIDeviceEvent& event) {
+        firstTouchPoints.insert(event.detail, QPointF(fixed1616ToReal(event.event_x), fixed1616ToReal(event.event_y)));
+    }
+
+    bool wantsTouchUpdates() {
+        //Only decoded while the gateway is being dragged open
+        return false;
+    }
+
+    void touchUpdate(const xXIDeviceEvent& event) {
+        Q_UNUSED(event)
+    }
+
+    void touchEnd(const xXIDeviceEvent& event) {
+        firstTouchPoints.remove(event.detail);
+    }
+
+    bool touchOwnership(const xXITouchOwnershipEvent& event) {
+        Q_UNUSED(event)
+        return false;
+    }
+
+    void rawTouch(const xXIRawEvent& event) {
+        lastTouchTime = event.time;
+    }
+
+    void rawTouchEnd(const xXIRawEvent& event) {
+        gestures.touchEnd(event.detail);
+    }
+
+    bool isTrackingRawTouch(const xXIRawEvent& event) {
+        return gestures.isTracking(event.detail);
+    }
+
+    void rawTouchPoint(int type, const xXIRawEvent& event, qreal axes[2]) {
+        QPointF point(screenGeometry.x() + (axes[0] - range.left()) / range.width() * screenGeometry.width(),
+                      screenGeometry.y() + (axes[1] - range.top()) / range.height() * screenGeometry.height());
+        if (type == XI_RawTouchBegin) {
+            gestures.touchBegin(event.detail, point);
+        } else {
+            gestures.touchUpdate(event.detail, point);
+        }
+    }
+};
+
+//The filter before XI2 events were decoded in place: every XI2 event was moved twice
+struct PreviousFilter {
+    int xiOpcode;
+    QHash<uint32_t, QPointF> firstTouchPoints;
+
+    void handle(xcb_generic_event_t* event) {
+        if ((event->response_type & 0x7f) != XCB_GE_GENERIC) return;
+        xcb_ge_generic_event_t* ge = reinterpret_cast<xcb_ge_generic_event_t*>(event);
+
+        memmove(reinterpret_cast<char*>(ge) + 32, reinterpret_cast<char*>(ge) + 36, ge->length * 4);
+        if (ge->extension == xiOpcode) {
+            switch (ge->event_type) {
+                case XI_TouchBegin: {
+                    xXIDeviceEvent* dEvent = reinterpret_cast<xXIDeviceEvent*>(event);
+                    firstTouchPoints.insert(dEvent->detail, QPointF(fixed1616ToReal(dEvent->event_x), fixed1616ToReal(dEvent->event_y)));
+                    break;
+                }
+                case XI_TouchEnd: {
+                    xXIDeviceEvent* dEvent = reinterpret_cast<xXIDeviceEvent*>(event);
+                    firstTouchPoints.remove(dEvent->detail);
+                    break;
+                }
+            }
+        }
+        memmove(reinterpret_cast<char*>(ge) + 36, reinterpret_cast<char*>(ge) + 32, ge->length * 4);
+    }
+};
+
+static int record(QString fileName, int seconds) {
+    QTextStream out(stdout);
+
+    xcb_connection_t* connection = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(connection)) {
+        out << "Couldn't connect to the X server\n";
+        return 1;
+    }
+
+    const xcb_query_extension_reply_t* extension = xcb_get_extension_data(connection, &xcb_input_id);
+    if (extension == nullptr || !extension->present) {
+        out << "The X server doesn't support XInput\n";
+        return 1;
+    }
+    free(xcb_input_xi_query_version_reply(connection, xcb_input_xi_query_version(connection, 2, 2), nullptr));
+
+    EventStream stream;
+    stream.xiOpcode = extension->major_opcode;
+
+    //Touch events can only be selected by one client, and the shell has them, so record the raw
+    //events and the pointer motion that make up most of what passes through the filter
+    struct {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } mask;
+    mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+    mask.head.mask_len = 1;
+    mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_TOUCH_BEGIN | XCB_INPUT_XI_EVENT_MASK_RAW_TOUCH_UPDATE | XCB_INPUT_XI_EVENT_MASK_RAW_TOUCH_END |
+                XCB_INPUT_XI_EVENT_MASK_RAW_MOTION | XCB_INPUT_XI_EVENT_MASK_MOTION;
+    xcb_window_t root = xcb_setup_roots_iterator(xcb_get_setup(connection)).data->root;
+    xcb_input_xi_select_events(connection, root, 1, &mask.head);
+    xcb_flush(connection);
+
+    out << "Recording for " << seconds << " seconds; touch the screen and move the pointer around\n";
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    pollfd fd;
+    fd.fd = xcb_get_file_descriptor(connection);
+    fd.events = POLLIN;
+    while (timer.elapsed() < seconds * 1000) {
+        while (xcb_generic_event_t* event = xcb_poll_for_event(connection)) {
+            if ((event->response_type & 0x7f) == XCB_GE_GENERIC) {
+                //xcb only allocates what the event needs, so copy it into a buffer of our own
+                quint32 size = EventStream::eventSize(event);
+                xcb_generic_event_t* copy = static_cast<xcb_generic_event_t*>(malloc(size));
+                memcpy(copy, event, size);
+                stream.events.push_back(copy);
+            }
+            free(event);
+        }
+        poll(&fd, 1, 100);
+    }
+    xcb_disconnect(connection);
+
+    if (!stream.save(fileName)) {
+        out << "Couldn't write " << fileName << "\n";
+        return 1;
+    }
+    out << "Recorded " << stream.events.size() << " events\n";
+    return 0;
+}
+
+static int synthesize(QString fileName, int count) {
+    //Mostly pointer motion that Qt selected for its own windows, with three finger swipes mixed in
+    EventStream stream;
+    stream.xiOpcode = 131;
+    EventBuilder builder;
+    builder.xiOpcode = stream.xiOpcode;
+
+    quint32 time = 0;
+    quint32 touchId = 1;
+    while (static_cast<int>(stream.events.size()) < count) {
+        for (int i = 0; i < 200; i++) {
+            time += 4;
+            qreal x = 500 + 300 * qSin(time / 500.0), y = 400 + 200 * qCos(time / 700.0);
+            stream.events.push_back(builder.deviceEvent(XI_Motion, 0, time, x, y));
+            stream.events.push_back(builder.rawEvent(XI_RawMotion, 0, time, 1, 1));
+        }
+
+        quint32 first = touchId;
+        for (int finger = 0; finger < 3; finger++) {
+            time += 2;
+            stream.events.push_back(builder.rawEvent(XI_RawTouchBegin, touchId, time, 1200 + finger * 80, 500 + finger * 20));
+            stream.events.push_back(builder.deviceEvent(XI_TouchBegin, touchId, time, 1200 + finger * 80, 500 + finger * 20));
+            touchId++;
+        }
+        for (int step = 1; step <= 50; step++) {
+            time += 8;
+            for (quint32 finger = 0; finger < 3; finger++) {
+                qreal x = 1200 + finger * 80 - step * 9, y = 500 + finger * 20;
+                stream.events.push_back(builder.rawEvent(XI_RawTouchUpdate, first + finger, time, x, y));
+                stream.events.push_back(builder.deviceEvent(XI_TouchUpdate, first + finger, time, x, y));
+            }
+        }
+        for (quint32 finger = 0; finger < 3; finger++) {
+            time += 2;
+            stream.events.push_back(builder.rawEvent(XI_RawTouchEnd, first + finger, time, 0, 0));
+            stream.events.push_back(builder.deviceEvent(XI_TouchEnd, first + finger, time, 0, 0));
+        }
+    }
+
+    QTextStream out(stdout);
+    if (!stream.save(fileName)) {
+        out << "Couldn't write " << fileName << "\n";
+        return 1;
+    }
+    out << "Wrote " << stream.events.size() << " events\n";
+    return 0;
+}
+
+template <typename T> static qreal timePasses(EventStream& stream, T& filter, int passes) {
+    //Report the median so that the odd context switch doesn't skew things
+    std::vector<qreal> results;
+    QElapsedTimer timer;
+    for (int pass = 0; pass < passes; pass++) {
+        timer.start();
+        for (xcb_generic_event_t* event : stream.events) {
+            filter.handle(event);
+        }
+        results.push_back(static_cast<qreal>(timer.nsecsElapsed()) / stream.events.size());
+    }
+    std::sort(results.begin(), results.end());
+    return results.at(results.size() / 2);
+}
+
+static int replay(QString fileName, int passes) {
+    QTextStream out(stdout);
+
+    EventStream stream;
+    if (!stream.load(fileName) || stream.events.empty()) {
+        out << "Couldn't read " << fileName << "\n";
+        return 1;
+    }
+
+    //The filter asks the device for its range; work it out from the stream instead
+    QRectF range;
+    int selected = 0;
+    CurrentFilter selection(stream.xiOpcode, QRectF());
+    for (xcb_generic_event_t* event : stream.events) {
+        xcb_ge_generic_event_t* ge = reinterpret_cast<xcb_ge_generic_event_t*>(event);
+        if (xiSelected(ge, stream.xiOpcode, selection.xiEvents)) selected++;
+        if (ge->extension != stream.xiOpcode || (ge->event_type != XI_RawTouchBegin && ge->event_type != XI_RawTouchUpdate)) continue;
+
+        xXIRawEvent rEvent;
+        xiWireEvent(event, &rEvent);
+        qreal axes[2];
+        if (!xiRawAxes(event, rEvent, axes)) continue;
+        range = range.isNull() ? QRectF(axes[0], axes[1], 1, 1) : range.united(QRectF(axes[0], axes[1], 1, 1));
+    }
+
+    CurrentFilter current(stream.xiOpcode, range);
+    PreviousFilter previous;
+    previous.xiOpcode = stream.xiOpcode;
+
+    //Warm up the caches and the recognizer before timing anything
+    timePasses(stream, current, 1);
+    timePasses(stream, previous, 1);
+    current.gesturesFinished = 0;
+
+    qreal currentCost = timePasses(stream, current, passes);
+    qreal previousCost = timePasses(stream, previous, passes);
+
+    out << "Events:           " << stream.events.size() << " (" << selected << " selected by the filter)\n";
+    out << "Gestures:         " << current.gesturesFinished / passes << " per pass\n";
+    out << "Current filter:   " << QString::number(currentCost, 'f', 1) << " ns per event\n";
+    out << "Previous filter:  " << QString::number(previousCost, 'f', 1) << " ns per event\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+
+    if (args.count() >= 3 && args.at(1) == "record") {
+        return record(args.at(2), args.count() > 3 ? args.at(3).toInt() : 10);
+    } else if (args.count() >= 3 && args.at(1) == "synthesize") {
+        return synthesize(args.at(2), args.count() > 3 ? args.at(3).toInt() : 100000);
+    } else if (args.count() >= 3 && args.at(1) == "replay") {
+        return replay(args.at(2), qMax(1, args.count() > 3 ? args.at(3).toInt() : 50));
+    }
+
+    QTextStream(stdout) << "Usage: " << args.first() << " record <file> [seconds] | synthesize <file> [events] | replay <file> [passes]\n";
+    return 1;
+}
@@ -0,0 +1,21 @@
+QT       -= gui
+CONFIG   += c++14 console
+CONFIG   -= app_bundle
+
+TARGET = xi2bench
+TEMPLATE = app
+
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += xcb xcb-xinput
+}
+
+INCLUDEPATH += $$PWD/../../shell
+
+SOURCES += \
+    main.cpp \
+    ../../shell/gestures/gesturerecognizer.cpp
+
+HEADERS += \
+    ../../shell/gestures/gesturerecognizer.h \
+    ../../shell/xi2wire.h